@@ -10,11 +10,17 @@
 #define STDEXT_ALGORITHM_INCLUDED
 #pragma once
 
+#include <stdext/execution.h>
 #include <stdext/range.h>
+#include <stdext/scope_guard.h>
 #include <stdext/tuple.h>
 
+#include <algorithm>
 #include <functional>
+#include <memory>
+#include <new>
 #include <random>
+#include <utility>
 #include <vector>
 
 
@@ -1097,190 +1103,799 @@ namespace stdext
 
     namespace _private
     {
-        template <typename Range, typename Compare>
-        range_position_type<Range> choose_pivot(const Range& range, Compare&& comp)
+        // Indexes the elements of a random-access range from a fixed position.  The sorting
+        // algorithms below work in terms of indices, and are equally happy with a raw pointer.
+        template <typename Range>
+        class indexed_position
         {
-            if (range.size() == 0)
-                return range.end_pos();
+        public:
+            indexed_position(const Range& range, range_position_type<Range> pos) : _range(&range), _pos(pos) { }
 
-            if (range.size() <= 8)
+        public:
+            range_reference_type<Range> operator [] (size_t n) const
             {
-                auto p = range.begin_pos();
-                range.advance_pos(p, range.size() / 2);
-                return p;
+                auto pos = _pos;
+                return _range->at_pos(_range->advance_pos(pos, range_difference_type<Range>(n)));
             }
 
-            auto delta = range.size() / 4;
+            indexed_position operator + (size_t n) const
+            {
+                auto pos = _pos;
+                return indexed_position(*_range, _range->advance_pos(pos, range_difference_type<Range>(n)));
+            }
 
-            auto p1 = range.begin_pos();
-            range.advance_pos(p1, delta);
-            auto p2 = range.begin_pos();
-            range.advance_pos(p2, 2 * delta);
-            auto p3 = range.begin_pos();
-            range.advance_pos(p3, 3 * delta);
+        private:
+            const Range* _range;
+            range_position_type<Range> _pos;
+        };
 
-            if (comp(range.at_pos(p2), range.at_pos(p1)))
-                swap(p1, p2);
-            if (comp(range.at_pos(p3), range.at_pos(p1)))
-                swap(p1, p3);
-            return comp(range.at_pos(p2), range.at_pos(p3)) ? p2 : p3;
+        template <typename Range>
+        auto index_range(const Range& range)
+        {
+            using position = range_position_type<Range>;
+            if constexpr (std::is_pointer_v<position> && std::is_same_v<range_reference_type<Range>, decltype(*declval<position>())>)
+                return range.begin_pos();
+            else
+                return indexed_position<Range>(range, range.begin_pos());
         }
 
-        template <typename Range, typename Compare>
-        range_position_type<Range> pivot_partition(const Range& range, Compare&& comp)
+        // Ranges this short are finished with an insertion sort.
+        constexpr size_t insertion_sort_limit = 16;
+        // Ranges this short are sorted on a single thread by the parallel algorithms, which
+        // also split partitions and merges into pieces of about this size.
+        constexpr size_t parallel_sort_limit = size_t(1) << 14;
+
+        // Quicksort falls back to heapsort after this many levels of partitioning.
+        inline unsigned sort_depth_limit(size_t size) noexcept
         {
-            auto pivot = _private::choose_pivot(range, comp);
-            if (range.is_end_pos(pivot))
-                return pivot;
+            unsigned depth = 0;
+            for (; size > 1; size >>= 1)
+                depth += 2;
+            return depth;
+        }
 
-            auto back_pos = prev_pos(range, range.end_pos());
-            if (pivot != back_pos)
+        template <typename Index, typename T, typename Compare>
+        size_t lower_bound_index(Index a, size_t size, const T& value, Compare& comp)
+        {
+            size_t first = 0;
+            while (size != 0)
             {
-                swap(range.at_pos(pivot), range.at_pos(back_pos));
-                pivot = back_pos;
+                auto half = size / 2;
+                if (comp(a[first + half], value))
+                {
+                    first += half + 1;
+                    size -= half + 1;
+                }
+                else
+                    size = half;
             }
 
-            pivot = partition(subrange_to(range, pivot),
-                [&](const auto& value)
+            return first;
+        }
+
+        template <typename Index, typename T, typename Compare>
+        size_t upper_bound_index(Index a, size_t size, const T& value, Compare& comp)
+        {
+            size_t first = 0;
+            while (size != 0)
+            {
+                auto half = size / 2;
+                if (!comp(value, a[first + half]))
+                {
+                    first += half + 1;
+                    size -= half + 1;
+                }
+                else
+                    size = half;
+            }
+
+            return first;
+        }
+
+        template <typename Index, typename Compare>
+        void insertion_sort(Index a, size_t size, Compare& comp)
+        {
+            for (size_t n = 1; n < size; ++n)
+            {
+                if (!comp(a[n], a[n - 1]))
+                    continue;
+
+                auto value = stdext::move(a[n]);
+                auto hole = n;
+                do
+                {
+                    a[hole] = stdext::move(a[hole - 1]);
+                    --hole;
+                } while (hole != 0 && comp(value, a[hole - 1]));
+                a[hole] = stdext::move(value);
+            }
+        }
+
+        template <typename Index, typename Compare>
+        void sift_down(Index a, size_t size, size_t hole, Compare& comp)
+        {
+            auto value = stdext::move(a[hole]);
+            while (true)
+            {
+                auto child = 2 * hole + 1;
+                if (child >= size)
+                    break;
+                if (child + 1 < size && comp(a[child], a[child + 1]))
+                    ++child;
+                if (!comp(value, a[child]))
+                    break;
+
+                a[hole] = stdext::move(a[child]);
+                hole = child;
+            }
+            a[hole] = stdext::move(value);
+        }
+
+        template <typename Index, typename Compare>
+        void heap_sort(Index a, size_t size, Compare& comp)
+        {
+            for (auto n = size / 2; n-- != 0; )
+                sift_down(a, size, n, comp);
+
+            for (auto n = size; n > 1; )
+            {
+                --n;
+                swap(a[0], a[n]);
+                sift_down(a, n, 0, comp);
+            }
+        }
+
+        template <typename Index, typename Compare>
+        size_t median_of_three(Index a, size_t i, size_t j, size_t k, Compare& comp)
+        {
+            if (comp(a[j], a[i]))
+                swap(i, j);
+            if (comp(a[k], a[j]))
+                j = comp(a[k], a[i]) ? i : k;
+            return j;
+        }
+
+        // Moves the median of a sample of the range to the front: three elements for short
+        // ranges, or the median of three such medians for longer ones.
+        template <typename Index, typename Compare>
+        void move_pivot_to_front(Index a, size_t size, Compare& comp)
+        {
+            size_t pivot;
+            if (size < 128)
+            {
+                auto delta = size / 4;
+                pivot = median_of_three(a, delta, 2 * delta, 3 * delta, comp);
+            }
+            else
+            {
+                auto delta = size / 8;
+                pivot = median_of_three(a,
+                    median_of_three(a, 0, delta, 2 * delta, comp),
+                    median_of_three(a, 3 * delta, 4 * delta, 5 * delta, comp),
+                    median_of_three(a, 6 * delta, 7 * delta, size - 1, comp),
+                    comp);
+            }
+
+            if (pivot != 0)
+                swap(a[0], a[pivot]);
+        }
+
+        // Partitions the range around a pivot and returns the pivot's final index.  Elements
+        // equal to the pivot stop both scans, so runs of equal keys split evenly.
+        template <typename Index, typename Compare>
+        size_t pivot_partition(Index a, size_t size, Compare& comp)
+        {
+            move_pivot_to_front(a, size, comp);
+            auto&& pivot = a[0];
+
+            size_t i = 1;
+            size_t j = size - 1;
+            while (true)
+            {
+                while (i <= j && comp(a[i], pivot))
+                    ++i;
+                while (i <= j && comp(pivot, a[j]))
+                    --j;
+                if (i >= j)
+                    break;
+
+                swap(a[i], a[j]);
+                ++i;
+                --j;
+            }
+
+            if (j != 0)
+                swap(a[0], a[j]);
+            return j;
+        }
+
+        template <typename Index, typename Compare>
+        void introsort(Index a, size_t size, Compare& comp, unsigned depth)
+        {
+            while (size > insertion_sort_limit)
+            {
+                if (depth == 0)
+                {
+                    heap_sort(a, size, comp);
+                    return;
+                }
+                --depth;
+
+                // Recursing on the smaller side keeps the stack logarithmic.
+                auto pivot = pivot_partition(a, size, comp);
+                auto right = size - pivot - 1;
+                if (pivot < right)
+                {
+                    introsort(a, pivot, comp, depth);
+                    a = a + (pivot + 1);
+                    size = right;
+                }
+                else
+                {
+                    introsort(a + (pivot + 1), right, comp, depth);
+                    size = pivot;
+                }
+            }
+
+            insertion_sort(a, size, comp);
+        }
+
+        template <typename Index, typename Compare>
+        void introselect(Index a, size_t size, size_t nth, Compare& comp, unsigned depth)
+        {
+            while (size > insertion_sort_limit)
+            {
+                if (depth == 0)
+                {
+                    heap_sort(a, size, comp);
+                    return;
+                }
+                --depth;
+
+                auto pivot = pivot_partition(a, size, comp);
+                if (nth == pivot)
+                    return;
+
+                if (nth < pivot)
+                    size = pivot;
+                else
+                {
+                    a = a + (pivot + 1);
+                    size -= pivot + 1;
+                    nth -= pivot + 1;
+                }
+            }
+
+            insertion_sort(a, size, comp);
+        }
+
+        template <typename Index, typename Compare, typename Buffer>
+        void merge_sort(Index a, size_t size, Compare& comp, Buffer& buf)
+        {
+            if (size <= insertion_sort_limit)
+            {
+                insertion_sort(a, size, comp);
+                return;
+            }
+
+            auto half = size / 2;
+            merge_sort(a, half, comp, buf);
+            merge_sort(a + half, size - half, comp, buf);
+            if (!comp(a[half], a[half - 1]))
+                return;
+
+            // Set the left half aside and merge it back in from the front.
+            for (size_t n = 0; n != half; ++n)
+                buf.emplace_back(stdext::move(a[n]));
+
+            size_t i = 0;
+            size_t j = half;
+            size_t k = 0;
+            while (i != half && j != size)
+            {
+                if (comp(a[j], buf[i]))
+                    a[k++] = stdext::move(a[j++]);
+                else
+                    a[k++] = stdext::move(buf[i++]);
+            }
+            for (; i != half; ++i)
+                a[k++] = stdext::move(buf[i]);
+
+            buf.clear();
+        }
+
+        template <typename Index>
+        void reverse_indices(Index a, size_t first, size_t last)
+        {
+            for (; first + 1 < last; ++first)
+                swap(a[first], a[--last]);
+        }
+
+        // Merges [0, middle) with [middle, size) by rotation, without extra storage.
+        template <typename Index, typename Compare>
+        void merge_in_place(Index a, size_t middle, size_t size, Compare& comp)
+        {
+            if (middle == 0 || middle == size)
+                return;
+
+            if (size == 2)
+            {
+                if (comp(a[1], a[0]))
+                    swap(a[0], a[1]);
+                return;
+            }
+
+            size_t cut1;
+            size_t cut2;
+            if (middle >= size - middle)
+            {
+                cut1 = middle / 2;
+                cut2 = middle + lower_bound_index(a + middle, size - middle, a[cut1], comp);
+            }
+            else
+            {
+                cut2 = middle + (size - middle) / 2;
+                cut1 = upper_bound_index(a, middle, a[cut2], comp);
+            }
+
+            reverse_indices(a, cut1, middle);
+            reverse_indices(a, middle, cut2);
+            reverse_indices(a, cut1, cut2);
+
+            auto split = cut1 + (cut2 - middle);
+            merge_in_place(a, cut1, split, comp);
+            merge_in_place(a + split, middle - cut1, size - split, comp);
+        }
+
+        template <typename Index, typename Compare>
+        void merge_sort_in_place(Index a, size_t size, Compare& comp)
+        {
+            if (size <= insertion_sort_limit)
+            {
+                insertion_sort(a, size, comp);
+                return;
+            }
+
+            auto half = size / 2;
+            merge_sort_in_place(a, half, comp);
+            merge_sort_in_place(a + half, size - half, comp);
+            merge_in_place(a, half, size, comp);
+        }
+
+        // Splits [0, size) into count nearly equal pieces and returns the start of piece n.
+        inline size_t piece_start(size_t size, size_t count, size_t n) noexcept
+        {
+            return n * (size / count) + std::min(n, size % count);
+        }
+
+        template <typename Index, typename Predicate>
+        size_t partition_index(Index a, size_t size, Predicate& pred)
+        {
+            size_t i = 0;
+            size_t j = size;
+            while (true)
+            {
+                while (i != j && pred(a[i]))
+                    ++i;
+                while (i != j && !pred(a[j - 1]))
+                    --j;
+                if (i == j)
+                    return i;
+
+                swap(a[i++], a[--j]);
+            }
+        }
+
+        // Moves the elements satisfying pred to the front and returns how many there are.  Each
+        // block of the range is partitioned on its own; the elements left on the wrong side of
+        // the overall boundary then come in equal numbers from either side, and are swapped
+        // pairwise.
+        template <typename Index, typename Predicate>
+        size_t parallel_partition(Index a, size_t size, Predicate& pred)
+        {
+            auto blocks = std::min(size_t(parallel_concurrency()) * 4, size / parallel_sort_limit);
+            if (blocks <= 1)
+                return partition_index(a, size, pred);
+
+            std::vector<size_t> counts(blocks);
+            parallel_for(0, blocks, [&](size_t n)
+            {
+                auto first = piece_start(size, blocks, n);
+                counts[n] = partition_index(a + first, piece_start(size, blocks, n + 1) - first, pred);
+            });
+
+            size_t boundary = 0;
+            for (auto count : counts)
+                boundary += count;
+
+            // Half-open intervals of misplaced elements, in order.
+            std::vector<std::pair<size_t, size_t>> left;
+            std::vector<std::pair<size_t, size_t>> right;
+            size_t misplaced = 0;
+            for (size_t n = 0; n != blocks; ++n)
+            {
+                auto first = piece_start(size, blocks, n);
+                auto middle = first + counts[n];
+                auto last = std::min(piece_start(size, blocks, n + 1), boundary);
+                if (middle < last)
+                {
+                    left.emplace_back(middle, last);
+                    misplaced += last - middle;
+                }
+
+                first = std::max(first, boundary);
+                if (first < middle)
+                    right.emplace_back(first, middle);
+            }
+
+            auto locate = [](const std::vector<std::pair<size_t, size_t>>& intervals, size_t offset)
+            {
+                size_t n = 0;
+                while (offset >= intervals[n].second - intervals[n].first)
+                {
+                    offset -= intervals[n].second - intervals[n].first;
+                    ++n;
+                }
+                return std::make_pair(n, intervals[n].first + offset);
+            };
+
+            auto pieces = (misplaced + parallel_sort_limit - 1) / parallel_sort_limit;
+            parallel_for(0, pieces, [&](size_t n)
             {
-                return comp(value, range.at_pos(pivot));
+                auto first = piece_start(misplaced, pieces, n);
+                auto count = piece_start(misplaced, pieces, n + 1) - first;
+                auto [i, p] = locate(left, first);
+                auto [j, q] = locate(right, first);
+                while (true)
+                {
+                    swap(a[p], a[q]);
+                    if (--count == 0)
+                        break;
+
+                    if (++p == left[i].second)
+                        p = left[++i].first;
+                    if (++q == right[j].second)
+                        q = right[++j].first;
+                }
+            });
+
+            return boundary;
+        }
+
+        // Like pivot_partition, but partitions in parallel.  Elements equal to the pivot all go to
+        // the right, so if nothing is less than the pivot, the elements equal to it are gathered
+        // at the front and their count is returned as well; otherwise the count is zero.
+        template <typename Index, typename Compare>
+        std::pair<size_t, size_t> parallel_pivot_partition(Index a, size_t size, Compare& comp)
+        {
+            move_pivot_to_front(a, size, comp);
+            auto&& pivot = a[0];
+
+            auto less = [&](const auto& value) { return bool(comp(value, pivot)); };
+            auto pos = parallel_partition(a + 1, size - 1, less);
+            if (pos != 0)
+            {
+                swap(a[0], a[pos]);
+                return { pos, 0 };
+            }
+
+            auto equal = [&](const auto& value) { return !comp(pivot, value); };
+            return { 0, parallel_partition(a + 1, size - 1, equal) + 1 };
+        }
+
+        template <typename Index, typename Compare>
+        void parallel_introsort(Index a, size_t size, Compare& comp, unsigned depth)
+        {
+            if (size <= parallel_sort_limit)
+            {
+                introsort(a, size, comp, depth);
+                return;
+            }
+
+            if (depth == 0)
+            {
+                heap_sort(a, size, comp);
+                return;
+            }
+
+            auto [pivot, equal] = parallel_pivot_partition(a, size, comp);
+            if (equal != 0)
+            {
+                parallel_introsort(a + equal, size - equal, comp, depth - 1);
+                return;
+            }
+
+            parallel_invoke(
+                [&] { parallel_introsort(a, pivot, comp, depth - 1); },
+                [&] { parallel_introsort(a + (pivot + 1), size - pivot - 1, comp, depth - 1); });
+        }
+
+        template <typename Index, typename Compare>
+        void parallel_introselect(Index a, size_t size, size_t nth, Compare& comp, unsigned depth)
+        {
+            while (size > parallel_sort_limit && depth != 0)
+            {
+                --depth;
+                auto [pivot, equal] = parallel_pivot_partition(a, size, comp);
+                if (equal != 0)
+                {
+                    if (nth < equal)
+                        return;
+                    pivot = equal - 1;
+                }
+                else if (nth == pivot)
+                    return;
+
+                if (nth < pivot)
+                    size = pivot;
+                else
+                {
+                    a = a + (pivot + 1);
+                    size -= pivot + 1;
+                    nth -= pivot + 1;
+                }
+            }
+
+            introselect(a, size, nth, comp, depth);
+        }
+
+        template <typename Source, typename Target, typename Compare>
+        void parallel_merge(Source a, size_t size_a, Source b, size_t size_b, Target out, Compare& comp)
+        {
+            if (size_a + size_b <= parallel_sort_limit)
+            {
+                size_t i = 0;
+                size_t j = 0;
+                size_t k = 0;
+                while (i != size_a && j != size_b)
+                {
+                    if (comp(b[j], a[i]))
+                        out[k++] = stdext::move(b[j++]);
+                    else
+                        out[k++] = stdext::move(a[i++]);
+                }
+                for (; i != size_a; ++i)
+                    out[k++] = stdext::move(a[i]);
+                for (; j != size_b; ++j)
+                    out[k++] = stdext::move(b[j]);
+                return;
+            }
+
+            // Split the longer run in half and the other where the middle element would go;
+            // equal elements from a stay ahead of those from b.
+            size_t i;
+            size_t j;
+            if (size_a >= size_b)
+            {
+                i = size_a / 2;
+                j = lower_bound_index(b, size_b, a[i], comp);
+            }
+            else
+            {
+                j = size_b / 2;
+                i = upper_bound_index(a, size_a, b[j], comp);
+            }
+
+            parallel_invoke(
+                [&] { parallel_merge(a, i, b, j, out, comp); },
+                [&] { parallel_merge(a + i, size_a - i, b + j, size_b - j, out + (i + j), comp); });
+        }
+
+        // Sorts from[0, size) stably, leaving the result in to if into is true and in from
+        // otherwise.  Both hold valid elements throughout; the other serves as scratch space.
+        template <typename Index1, typename Index2, typename Compare>
+        void parallel_merge_sort(Index1 from, Index2 to, size_t size, bool into, Compare& comp)
+        {
+            if (size <= insertion_sort_limit)
+            {
+                insertion_sort(from, size, comp);
+                if (into)
+                {
+                    for (size_t n = 0; n != size; ++n)
+                        to[n] = stdext::move(from[n]);
+                }
+                return;
+            }
+
+            auto half = size / 2;
+            auto sort_left = [&] { parallel_merge_sort(from, to, half, !into, comp); };
+            auto sort_right = [&] { parallel_merge_sort(from + half, to + half, size - half, !into, comp); };
+            if (size > parallel_sort_limit)
+                parallel_invoke(sort_left, sort_right);
+            else
+            {
+                sort_left();
+                sort_right();
+            }
+
+            if (into)
+                parallel_merge(from, half, from + half, size - half, to, comp);
+            else
+                parallel_merge(to, half, to + half, size - half, from, comp);
+        }
+
+        template <typename Index, typename Compare>
+        void parallel_stable_sort(Index a, size_t size, Compare& comp)
+        {
+            using value_type = remove_cvref_t<decltype(a[0])>;
+
+            std::allocator<value_type> allocator;
+            value_type* buf;
+            try
+            {
+                buf = allocator.allocate(size);
+            }
+            catch (const std::bad_alloc&)
+            {
+                merge_sort_in_place(a, size, comp);
+                return;
+            }
+
+            // The elements are moved into the buffer and sorted back into the range.
+            auto pieces = (size + parallel_sort_limit - 1) / parallel_sort_limit;
+            parallel_for(0, pieces, [&](size_t n)
+            {
+                auto first = piece_start(size, pieces, n);
+                auto last = piece_start(size, pieces, n + 1);
+                for (auto i = first; i != last; ++i)
+                    ::new (static_cast<void*>(buf + i)) value_type(stdext::move(a[i]));
+            });
+
+            scope_guard release([&]
+            {
+                std::destroy_n(buf, size);
+                allocator.deallocate(buf, size);
             });
-            if (pivot != back_pos)
-                swap(range.at_pos(back_pos), range.at_pos(pivot));
 
-            return pivot;
+            parallel_merge_sort(buf, a, size, true, comp);
         }
     }
 
     template <typename Range, typename Compare,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
     void nth_element(const Range& range, range_position_type<Range> nth, Compare&& comp)
     {
         if (range.is_end_pos(nth))
             return;
 
-        auto pivot = _private::pivot_partition(range, comp);
-        auto dist = range.distance(pivot, nth);
-        if (dist < 0)
-            nth_element(subrange_to(range, pivot), nth, comp);
-        else if (dist > 0)
-            nth_element(subrange_from(range, next_pos(range, pivot)), nth, comp);
+        auto size = size_t(range.size());
+        _private::introselect(_private::index_range(range), size, size_t(range.distance(range.begin_pos(), nth)),
+            comp, _private::sort_depth_limit(size));
     }
 
     template <typename Range,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
     void nth_element(const Range& range, range_position_type<Range> nth)
     {
         nth_element(range, nth, std::less<>());
     }
 
-    template <typename Range, typename Compare,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
-    void sort(const Range& range, Compare&& comp)
+    template <typename ExecutionPolicy, typename Range, typename Compare,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void nth_element(ExecutionPolicy&&, const Range& range, range_position_type<Range> nth, Compare&& comp)
     {
-        if (range.size() <= 1)
-            return;
+        if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::parallel_policy>)
+        {
+            if (range.is_end_pos(nth))
+                return;
 
-        auto pivot = _private::pivot_partition(range, comp);
-        if (range.is_end_pos(pivot))
-            return;
+            auto size = size_t(range.size());
+            auto index = size_t(range.distance(range.begin_pos(), nth));
+            _private::parallel_run([&]
+            {
+                _private::parallel_introselect(_private::index_range(range), size, index, comp, _private::sort_depth_limit(size));
+            });
+        }
+        else
+            nth_element(range, nth, comp);
+    }
+
+    template <typename ExecutionPolicy, typename Range,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void nth_element(ExecutionPolicy&& policy, const Range& range, range_position_type<Range> nth)
+    {
+        nth_element(stdext::forward<ExecutionPolicy>(policy), range, nth, std::less<>());
+    }
 
-        sort(subrange_to(range, pivot), comp);
-        sort(subrange_from(range, next_pos(range, pivot)), comp);
+    template <typename Range, typename Compare,
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
+    void sort(const Range& range, Compare&& comp)
+    {
+        auto size = size_t(range.size());
+        _private::introsort(_private::index_range(range), size, comp, _private::sort_depth_limit(size));
     }
 
     template <typename Range,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
     void sort(const Range& range)
     {
         sort(range, std::less<>());
     }
 
-    namespace _private
+    template <typename ExecutionPolicy, typename Range, typename Compare,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void sort(ExecutionPolicy&&, const Range& range, Compare&& comp)
     {
-        template <typename Range, typename Compare>
-        void fast_stable_sort(const Range& range, Compare&& comp, std::vector<range_value_type<Range>>& buf)
+        if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::parallel_policy>)
         {
-            if (range.size() <= 1)
-                return;
-
-            auto l = range.begin_pos();
-            auto r = next_pos(range, l);
-            auto pred = [&](const auto& value)
+            auto size = size_t(range.size());
+            _private::parallel_run([&]
             {
-                return comp(value, range.at_pos(l));
-            };
-
-            while (true)
-            {
-                auto mid = find_if(subrange_from(range, r), pred);
-                if (range.is_end_pos(mid))
-                    break;
-
-                r = find_if_not(subrange_from(range, next_pos(range, mid)), pred);
-                for (auto pos = l; pos != mid; range.inc_pos(pos))
-                    buf.emplace_back(stdext::move(range.at_pos(pos)));
-                l = move(make_range(range, mid, r), make_range(range, l, r)).second;
-                move(make_range(buf.begin(), buf.end()), make_range(range, l, r));
-                buf.resize(0);
-            }
-
-            fast_stable_sort(subrange_to(range, l), comp, buf);
-            fast_stable_sort(subrange_from(range, next_pos(range, l)), comp, buf);
+                _private::parallel_introsort(_private::index_range(range), size, comp, _private::sort_depth_limit(size));
+            });
         }
+        else
+            sort(range, comp);
+    }
 
-        template <typename Range, typename Compare>
-        void slow_stable_sort(const Range& range, Compare&& comp)
-        {
-            if (range.size() <= 1)
-                return;
-
-            auto l = range.begin_pos();
-            auto r = next_pos(range, l);
-            auto pred = [&](const auto& value)
-            {
-                return comp(value, range.at_pos(l));
-            };
-
-            while (true)
-            {
-                auto mid = find_if(subrange_from(range, r), pred);
-                if (range.is_end_pos(mid))
-                    break;
-                r = find_if_not(subrange_from(range, next_pos(range, mid)), pred);
-                l = rotate(make_range(range, l, r), mid);
-            }
-
-            stable_sort(subrange_to(range, l), comp);
-            stable_sort(subrange_from(range, next_pos(range, l)), comp);
-        }
+    template <typename ExecutionPolicy, typename Range,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void sort(ExecutionPolicy&& policy, const Range& range)
+    {
+        sort(stdext::forward<ExecutionPolicy>(policy), range, std::less<>());
     }
 
     template <typename Range, typename Compare,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
     void stable_sort(const Range& range, Compare&& comp)
     {
+        auto a = _private::index_range(range);
+        auto size = size_t(range.size());
+
         std::vector<range_value_type<Range>> buf;
         try
         {
-            buf.reserve(range.size());
+            buf.reserve(size / 2);
         }
         catch (const std::bad_alloc&)
         {
-            _private::slow_stable_sort(range, comp);
+            _private::merge_sort_in_place(a, size, comp);
             return;
         }
 
-        _private::fast_stable_sort(range, comp, buf);
+        _private::merge_sort(a, size, comp, buf);
     }
 
     template <typename Range,
-        STDEXT_REQUIRES(is_random_access_range<Range>::value && is_counted_range<Range>::value)>
+        STDEXT_REQUIRES(std::conjunction_v<is_random_access_range<Range>, is_counted_range<Range>>)>
     void stable_sort(const Range& range)
     {
         stable_sort(range, std::less<>());
     }
 
+    // The parallel stable sort needs a buffer as large as the range, and falls back to the
+    // sequential algorithm for elements that might throw when moved.
+    template <typename ExecutionPolicy, typename Range, typename Compare,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void stable_sort(ExecutionPolicy&&, const Range& range, Compare&& comp)
+    {
+        using value_type = remove_cvref_t<range_reference_type<Range>>;
+        if constexpr (std::is_same_v<remove_cvref_t<ExecutionPolicy>, execution::parallel_policy>
+            && std::is_nothrow_move_constructible_v<value_type>)
+        {
+            auto size = size_t(range.size());
+            if (size <= _private::parallel_sort_limit)
+            {
+                stable_sort(range, comp);
+                return;
+            }
+
+            _private::parallel_run([&]
+            {
+                _private::parallel_stable_sort(_private::index_range(range), size, comp);
+            });
+        }
+        else
+            stable_sort(range, comp);
+    }
+
+    template <typename ExecutionPolicy, typename Range,
+        STDEXT_REQUIRES(std::conjunction_v<is_execution_policy<remove_cvref_t<ExecutionPolicy>>, is_random_access_range<Range>, is_counted_range<Range>>)>
+    void stable_sort(ExecutionPolicy&& policy, const Range& range)
+    {
+        stable_sort(stdext::forward<ExecutionPolicy>(policy), range, std::less<>());
+    }
+
     template <typename Range, typename Compare,
         STDEXT_REQUIRES(is_random_access_range<Range>::value && is_delimited_range<Range>::value)>
     void partial_sort(const Range& range, range_position_type<Range> middle, Compare&& comp)
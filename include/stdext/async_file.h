@@ -0,0 +1,101 @@
+//
+//  async_file.h
+//  stdext
+//
+//  Created by James Touton on 10/17/26.
+//  Copyright © 2026 James Touton. All rights reserved.
+//
+
+#ifndef STDEXT_ASYNC_FILE_INCLUDED
+#define STDEXT_ASYNC_FILE_INCLUDED
+#pragma once
+
+#include <stdext/file.h>
+#include <stdext/span.h>
+
+#include <functional>
+#include <memory>
+#include <system_error>
+
+
+namespace stdext
+{
+    enum class async_file_mode
+    {
+        read,
+        read_write
+    };
+
+    enum class async_file_backend
+    {
+        automatic,      // When opening, selects the best backend available.
+        io_uring,       // Requests are handed directly to the kernel (Linux only).
+        thread_pool     // Requests are serviced with blocking positional I/O on worker threads.
+    };
+
+    // Receives the outcome of an asynchronous request.  On success, size is the number of bytes
+    // transferred, which is less than requested only at end of file.
+    using async_completion = std::function<void(const std::error_code& error, size_t size)>;
+
+    namespace _private
+    {
+        class async_engine;
+    }
+
+    // Issues many positional reads and writes against a single file concurrently.  Requests are
+    // queued by read_at and write_at and handed to the backend by submit (or wait); up to
+    // queue_depth requests are in flight at once, and the remainder are submitted as earlier
+    // ones complete.  Completion callbacks are only ever invoked from poll, wait, or wait_all,
+    // on the calling thread.  Buffers must remain valid until their request completes.  Opening
+    // with a specific backend fails with errc::not_supported if that backend is unavailable.
+    class async_file
+    {
+    private:
+        static constexpr flags<file_open_flags> default_flags = file_open_flags::none;
+
+    public:
+        static constexpr unsigned default_queue_depth = 128;
+
+    public:
+        async_file() noexcept;
+        async_file(const async_file&) = delete;
+        async_file& operator = (const async_file&) = delete;
+        async_file(async_file&& other) noexcept;
+        async_file& operator = (async_file&& other);
+        ~async_file();
+
+        explicit async_file(const path_char* path, async_file_mode mode = async_file_mode::read, flags<file_open_flags> flags = default_flags, unsigned queue_depth = default_queue_depth, async_file_backend backend = async_file_backend::automatic);
+        async_file(const char* path, utf8_path_encoding, async_file_mode mode = async_file_mode::read, flags<file_open_flags> flags = default_flags, unsigned queue_depth = default_queue_depth, async_file_backend backend = async_file_backend::automatic);
+
+    public:
+        std::error_code open(const path_char* path, async_file_mode mode = async_file_mode::read, flags<file_open_flags> flags = default_flags, unsigned queue_depth = default_queue_depth, async_file_backend backend = async_file_backend::automatic);
+        std::error_code open(const char* path, utf8_path_encoding, async_file_mode mode = async_file_mode::read, flags<file_open_flags> flags = default_flags, unsigned queue_depth = default_queue_depth, async_file_backend backend = async_file_backend::automatic);
+        bool is_open() const noexcept;
+        // Waits for all outstanding requests before closing the file.
+        void close();
+
+        async_file_backend backend() const noexcept;
+
+        void read_at(stream_position position, span<byte> buffer, async_completion completion);
+        void write_at(stream_position position, span<const byte> buffer, async_completion completion);
+
+        // Hands queued requests to the backend without waiting.  Returns the number submitted.
+        size_t submit();
+        // Runs the callbacks for any requests that have already completed.  Returns the number
+        // of callbacks run.
+        size_t poll();
+        // Submits queued requests, then blocks until at least count of them (or all outstanding
+        // requests, if fewer) have completed.  Returns the number of callbacks run.
+        size_t wait(size_t count = 1);
+        void wait_all();
+
+        // The number of requests that have been queued but whose callbacks have not yet run.
+        size_t pending() const noexcept;
+
+    private:
+        file_handle_t _handle;
+        std::unique_ptr<_private::async_engine> _engine;
+    };
+}
+
+#endif
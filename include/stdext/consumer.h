@@ -11,6 +11,9 @@
 #pragma once
 
 #include <stdext/iterator.h>
+#include <stdext/span.h>
+
+#include <algorithm>
 
 
 namespace stdext
@@ -18,6 +21,21 @@ namespace stdext
     template <typename T, typename Elem> struct is_consumer : std::is_invocable_r<bool, T, Elem> { };
     template <typename T, typename Elem> constexpr auto is_consumer_v = is_consumer<T, Elem>::value;
 
+    // A consumer may also accept elements in bulk: c(span<const Elem>) consumes a prefix of the
+    // span and returns its length, which falls short only where c would have returned false for
+    // the next element on its own.
+    namespace _private
+    {
+        template <typename T, typename Elem, typename = void>
+        struct is_chunk_consumer_base : false_type { };
+
+        template <typename T, typename Elem>
+        struct is_chunk_consumer_base<T, Elem, std::void_t<std::invoke_result_t<T&, span<const Elem>>>>
+            : std::is_same<std::invoke_result_t<T&, span<const Elem>>, size_t> { };
+    }
+    template <typename T, typename Elem> struct is_chunk_consumer : _private::is_chunk_consumer_base<T, Elem> { };
+    template <typename T, typename Elem> constexpr auto is_chunk_consumer_v = is_chunk_consumer<T, Elem>::value;
+
     // I would love to add is_consumer_adaptable, as_consumer, and can_consume, but I can't
     // because there's no way to force is_consumer_adaptable to see make_consumer<Elem> as
     // a dependent function template.  C++20 will do this by default!
@@ -42,6 +60,13 @@ namespace stdext
             return true;
         }
 
+        template <typename T, STDEXT_REQUIRES(std::is_assignable_v<decltype(*declval<iterator&>()), const T&>)>
+        constexpr size_t operator () (span<const T> values)
+        {
+            _i = std::copy_n(values.data(), values.size(), stdext::move(_i));
+            return values.size();
+        }
+
     private:
         iterator _i;
     };
@@ -76,6 +101,24 @@ namespace stdext
             return true;
         }
 
+        template <typename T, STDEXT_REQUIRES(std::is_assignable_v<decltype(*declval<iterator&>()), const T&>)>
+        constexpr size_t operator () (span<const T> values)
+        {
+            if constexpr (is_random_access_iterator_v<iterator> && std::is_same_v<iterator, sentinel>)
+            {
+                auto count = std::min(values.size(), size_t(_j - _i));
+                _i = std::copy_n(values.data(), count, stdext::move(_i));
+                return count;
+            }
+            else
+            {
+                size_t count = 0;
+                for (; count != values.size() && _i != _j; ++count, ++_i)
+                    *_i = values[count];
+                return count;
+            }
+        }
+
     private:
         iterator _i;
         sentinel _j;
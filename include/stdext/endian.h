@@ -5,10 +5,36 @@
 #include <stdext/stream.h>
 #include <stdext/traits.h>
 
-#if STDEXT_ARCH_X86 && !STDEXT_COMPILER_GCC
+#include <algorithm>
+#include <cstring>
+
+// Bulk conversions use whichever byte shuffle instructions the target is compiled for.
+#if STDEXT_ARCH_X86 && defined(__AVX2__)
+#define STDEXT_ENDIAN_AVX2 1
+#else
+#define STDEXT_ENDIAN_AVX2 0
+#endif
+
+#if STDEXT_ARCH_X86 && (defined(__SSSE3__) || defined(__AVX__))
+#define STDEXT_ENDIAN_SSSE3 1
+#else
+#define STDEXT_ENDIAN_SSSE3 0
+#endif
+
+#if (STDEXT_ARCH_ARM || STDEXT_ARCH_ARM64) && defined(__ARM_NEON)
+#define STDEXT_ENDIAN_NEON 1
+#else
+#define STDEXT_ENDIAN_NEON 0
+#endif
+
+#if STDEXT_ARCH_X86 && (!STDEXT_COMPILER_GCC || STDEXT_ENDIAN_SSSE3)
 #include <immintrin.h>
 #endif
 
+#if STDEXT_ENDIAN_NEON
+#include <arm_neon.h>
+#endif
+
 
 #if STDEXT_LITTLE_ENDIAN
 #define STDEXT_BYTE_ORDER_NATIVE little_endian
@@ -68,6 +94,15 @@ namespace stdext
     namespace _private
     {
         template <byte_order Order, typename T> struct endian;
+
+        // True if converting to or from Order reverses the bytes of each value.
+        template <byte_order Order>
+        constexpr bool reverses_bytes =
+            (byte_order::native_endian == byte_order::little_endian && Order == byte_order::big_endian)
+            || (byte_order::native_endian == byte_order::big_endian && Order == byte_order::little_endian);
+
+        template <size_t Size>
+        void reverse_element_bytes(const byte* in, byte* out, size_t count) noexcept;
     }
 
     template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
@@ -80,6 +115,31 @@ namespace stdext
         return T(_private::endian<Order, sized_t>::swap(sized_t(v)));
     }
 
+    // Converts count values between native byte order and Order.  in and out may refer to the
+    // same buffer, but must not otherwise overlap.
+    template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
+    void endian_swap(const T* in, T* out, size_t count) noexcept
+    {
+        if constexpr (Order == byte_order::native_endian || sizeof(T) == 1)
+        {
+            if (in != out)
+                std::copy_n(in, count, out);
+        }
+        else if constexpr (_private::reverses_bytes<Order>)
+            _private::reverse_element_bytes<sizeof(T)>(reinterpret_cast<const byte*>(in), reinterpret_cast<byte*>(out), count);
+        else
+        {
+            for (size_t n = 0; n != count; ++n)
+                out[n] = endian_swap<Order>(in[n]);
+        }
+    }
+
+    template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
+    void endian_swap(span<T> values) noexcept
+    {
+        endian_swap<Order>(values.data(), values.data(), values.size());
+    }
+
     template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
     T read(input_stream& s)
     {
@@ -91,19 +151,14 @@ namespace stdext
     size_t read(input_stream& s, T* buffer, size_t count)
     {
         count = s.read(buffer, count);
-        if constexpr (Order != byte_order::native_endian)
-        {
-            for (size_t n = 0; n < count; ++n)
-                buffer[n] = endian_swap<Order>(buffer[n]);
-        }
+        endian_swap<Order>(buffer, buffer, count);
         return count;
     }
 
     template <byte_order Order, typename T, size_t Length, STDEXT_REQUIRES(std::is_integral_v<T>)>
     size_t read(input_stream& s, T (&buffer)[Length])
     {
-        using sized_t = equivalent_sized_type_t<T>;
-        return _private::endian<Order, sized_t>::read(s, buffer, Length);
+        return read<Order>(s, buffer, Length);
     }
 
     template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
@@ -115,23 +170,33 @@ namespace stdext
     template <byte_order Order, typename T, STDEXT_REQUIRES(std::is_integral_v<T>)>
     size_t write(output_stream& s, const T* buffer, size_t count)
     {
-        if constexpr (Order == byte_order::native_endian)
+        if constexpr (Order == byte_order::native_endian || sizeof(T) == 1)
             return s.write(buffer, count);
-
-        size_t n = 0;
-        for (; n < count; ++n)
+        else
         {
-            auto v = endian_swap<Order>(buffer[n]);
-            if (s.write(&v, 1) == 0)
-                break;
+            // Values are converted into a staging block, which is then written in one call.
+            constexpr size_t block_count = 0x1000 / sizeof(T);
+            T block[block_count];
+
+            size_t n = 0;
+            while (n != count)
+            {
+                auto chunk = std::min(count - n, block_count);
+                endian_swap<Order>(buffer + n, block, chunk);
+                auto written = s.write(block, chunk);
+                n += written;
+                if (written != chunk)
+                    break;
+            }
+
+            return n;
         }
-        return n;
     }
 
     template <byte_order Order, typename T, size_t Length, STDEXT_REQUIRES(std::is_integral_v<T>)>
     size_t write(output_stream& s, const T (&buffer)[Length])
     {
-        return write(s, buffer, Length);
+        return write<Order>(s, buffer, Length);
     }
 
     namespace _private
@@ -427,6 +492,66 @@ namespace stdext
 #endif
     }
 
+    namespace _private
+    {
+        template <size_t Size>
+        void reverse_element_bytes(const byte* in, byte* out, size_t count) noexcept
+        {
+            static_assert(Size == 2 || Size == 4 || Size == 8);
+
+            auto size = count * Size;
+            size_t offset = 0;
+
+#if STDEXT_ENDIAN_SSSE3
+            // Reverses each Size-byte group within a 16-byte lane.
+            __m128i mask;
+            if constexpr (Size == 2)
+                mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            else if constexpr (Size == 4)
+                mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            else
+                mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+#if STDEXT_ENDIAN_AVX2
+            auto wide_mask = _mm256_broadcastsi128_si256(mask);
+            for (; size - offset >= 32; offset += 32)
+            {
+                auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + offset));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + offset), _mm256_shuffle_epi8(v, wide_mask));
+            }
+#endif
+
+            for (; size - offset >= 16; offset += 16)
+            {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + offset));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + offset), _mm_shuffle_epi8(v, mask));
+            }
+#elif STDEXT_ENDIAN_NEON
+            for (; size - offset >= 16; offset += 16)
+            {
+                auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + offset));
+                if constexpr (Size == 2)
+                    v = vrev16q_u8(v);
+                else if constexpr (Size == 4)
+                    v = vrev32q_u8(v);
+                else
+                    v = vrev64q_u8(v);
+                vst1q_u8(reinterpret_cast<uint8_t*>(out + offset), v);
+            }
+#endif
+
+            using uint_t = std::conditional_t<Size == 2, uint16_t, std::conditional_t<Size == 4, uint32_t, uint64_t>>;
+            constexpr auto order = byte_order::native_endian == byte_order::little_endian ? byte_order::big_endian : byte_order::little_endian;
+            for (; offset != size; offset += Size)
+            {
+                uint_t v;
+                std::memcpy(&v, in + offset, Size);
+                v = endian<order, uint_t>::swap(v);
+                std::memcpy(out + offset, &v, Size);
+            }
+        }
+    }
+
     template <typename T, byte_order ByteOrder, STDEXT_REQUIRED(std::is_integral_v<T>)>
     class endian_int
     {
@@ -512,6 +637,128 @@ namespace stdext
         T value_;
     };
 
+    // A read-only view of a byte buffer as a sequence of integers of type T stored in the given
+    // byte order.  Elements are converted to native order as they are accessed, so the buffer
+    // needs no particular alignment and is never copied as a whole.
+    template <typename T, byte_order Order>
+    class endian_span
+    {
+        static_assert(std::is_integral_v<T>);
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        class iterator
+        {
+        public:
+            using value_type = T;
+            using difference_type = ptrdiff_t;
+            using pointer = void;
+            using reference = T;
+            using iterator_category = std::random_access_iterator_tag;
+
+        public:
+            constexpr iterator() noexcept = default;
+
+        private:
+            friend class endian_span;
+            constexpr explicit iterator(const byte* p) noexcept : _p(p) { }
+
+        public:
+            friend constexpr bool operator == (const iterator& a, const iterator& b) noexcept { return a._p == b._p; }
+            friend constexpr bool operator != (const iterator& a, const iterator& b) noexcept { return a._p != b._p; }
+            friend constexpr bool operator < (const iterator& a, const iterator& b) noexcept { return a._p < b._p; }
+            friend constexpr bool operator > (const iterator& a, const iterator& b) noexcept { return a._p > b._p; }
+            friend constexpr bool operator <= (const iterator& a, const iterator& b) noexcept { return a._p <= b._p; }
+            friend constexpr bool operator >= (const iterator& a, const iterator& b) noexcept { return a._p >= b._p; }
+
+            friend constexpr iterator operator + (iterator i, difference_type n) noexcept { return i += n; }
+            friend constexpr iterator operator + (difference_type n, iterator i) noexcept { return i += n; }
+            friend constexpr iterator operator - (iterator i, difference_type n) noexcept { return i -= n; }
+            friend constexpr difference_type operator - (const iterator& a, const iterator& b) noexcept { return (a._p - b._p) / difference_type(sizeof(T)); }
+
+        public:
+            T operator * () const noexcept { return endian_span::load(_p); }
+            T operator [] (difference_type n) const noexcept { return endian_span::load(_p + n * difference_type(sizeof(T))); }
+
+            constexpr iterator& operator ++ () noexcept { _p += sizeof(T); return *this; }
+            constexpr iterator operator ++ (int) noexcept { auto i = *this; ++*this; return i; }
+            constexpr iterator& operator -- () noexcept { _p -= sizeof(T); return *this; }
+            constexpr iterator operator -- (int) noexcept { auto i = *this; --*this; return i; }
+            constexpr iterator& operator += (difference_type n) noexcept { _p += n * difference_type(sizeof(T)); return *this; }
+            constexpr iterator& operator -= (difference_type n) noexcept { _p -= n * difference_type(sizeof(T)); return *this; }
+
+        private:
+            const byte* _p = nullptr;
+        };
+
+        using const_iterator = iterator;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+
+    public:
+        constexpr endian_span() noexcept = default;
+        constexpr endian_span(const byte* data, size_type count) noexcept : _data(data), _size(count) { }
+        // Any trailing bytes that do not form a whole element are excluded.
+        constexpr explicit endian_span(span<const byte> bytes) noexcept : _data(bytes.data()), _size(bytes.size() / sizeof(T)) { }
+
+    public:
+        constexpr const byte* data() const noexcept { return _data; }
+        constexpr size_type size() const noexcept { return _size; }
+        constexpr size_type size_bytes() const noexcept { return _size * sizeof(T); }
+        [[nodiscard]] constexpr bool empty() const noexcept { return _size == 0; }
+
+        T operator [] (size_type index) const noexcept { assert(index < _size); return load(_data + index * sizeof(T)); }
+        T front() const noexcept { return (*this)[0]; }
+        T back() const noexcept { return (*this)[_size - 1]; }
+
+        constexpr iterator begin() const noexcept { return iterator(_data); }
+        constexpr iterator end() const noexcept { return iterator(_data + size_bytes()); }
+        constexpr reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+        constexpr reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+
+        constexpr endian_span first(size_type count) const noexcept { assert(count <= _size); return { _data, count }; }
+        constexpr endian_span last(size_type count) const noexcept { assert(count <= _size); return { _data + (_size - count) * sizeof(T), count }; }
+        constexpr endian_span subspan(size_type offset) const noexcept { assert(offset <= _size); return { _data + offset * sizeof(T), _size - offset }; }
+        constexpr endian_span subspan(size_type offset, size_type count) const noexcept { assert(offset <= _size && count <= _size - offset); return { _data + offset * sizeof(T), count }; }
+
+        // Converts as many elements as fit in out to native order, using the vectorized byte
+        // reversal where possible.  Returns the number of elements converted.
+        size_type copy_to_native(span<T> out) const noexcept
+        {
+            auto count = std::min(_size, out.size());
+            auto dest = reinterpret_cast<byte*>(out.data());
+            // The source may be misaligned, so it is only ever accessed as bytes.
+            if constexpr (Order == byte_order::native_endian || sizeof(T) == 1)
+                std::memcpy(dest, _data, count * sizeof(T));
+            else if constexpr (_private::reverses_bytes<Order>)
+                _private::reverse_element_bytes<sizeof(T)>(_data, dest, count);
+            else
+            {
+                for (size_type n = 0; n != count; ++n)
+                    out[n] = (*this)[n];
+            }
+            return count;
+        }
+
+    private:
+        static T load(const byte* p) noexcept
+        {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return endian_swap<Order>(value);
+        }
+
+    private:
+        const byte* _data = nullptr;
+        size_type _size = 0;
+    };
+
+    template <typename T> using endian_span_le = endian_span<T, byte_order::little_endian>;
+    template <typename T> using endian_span_be = endian_span<T, byte_order::big_endian>;
+    template <typename T> using endian_span_pdp = endian_span<T, byte_order::pdp_endian>;
+
     inline namespace literals
     {
         inline namespace endian
@@ -584,5 +831,8 @@ namespace stdext
 }
 
 #undef STDEXT_BYTE_ORDER_NATIVE
+#undef STDEXT_ENDIAN_AVX2
+#undef STDEXT_ENDIAN_SSSE3
+#undef STDEXT_ENDIAN_NEON
 
 #endif
@@ -0,0 +1,177 @@
+//
+//  execution.h
+//  stdext
+//
+//  Created by James Touton on 10/17/26.
+//  Copyright © 2026 James Touton. All rights reserved.
+//
+
+#ifndef STDEXT_EXECUTION_INCLUDED
+#define STDEXT_EXECUTION_INCLUDED
+#pragma once
+
+#include <stdext/utility.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+
+namespace stdext
+{
+    // Execution policies select between the ordinary algorithm (seq) and one that divides the
+    // work among the threads of a shared pool (par).  Under par, comparisons and element
+    // accesses may run concurrently on any of those threads.  Unlike the standard policies, an
+    // exception doesn't terminate the program: it's rethrown on the calling thread once all
+    // outstanding work has finished.
+    namespace execution
+    {
+        class sequenced_policy { };
+        class parallel_policy { };
+
+        inline constexpr sequenced_policy seq;
+        inline constexpr parallel_policy par;
+    }
+
+    template <typename T> struct is_execution_policy : false_type { };
+    template <> struct is_execution_policy<execution::sequenced_policy> : true_type { };
+    template <> struct is_execution_policy<execution::parallel_policy> : true_type { };
+    template <typename T> constexpr auto is_execution_policy_v = is_execution_policy<T>::value;
+
+    namespace _private
+    {
+        // A unit of fork-join work.  Tasks live on the stack of the thread that forks them, which
+        // must join them before they go out of scope.  Each pool thread keeps a deque of the tasks
+        // it has forked; it pops from the back, and idle threads steal from the front.
+        class parallel_task
+        {
+        public:
+            explicit parallel_task(void (*run)(parallel_task& task) noexcept) noexcept : _run(run) { }
+            parallel_task(const parallel_task&) = delete;
+            parallel_task& operator = (const parallel_task&) = delete;
+
+        public:
+            void run() noexcept
+            {
+                _run(*this);
+                _done.store(true, std::memory_order_release);
+            }
+
+            bool done() const noexcept { return _done.load(std::memory_order_acquire); }
+
+        private:
+            void (*_run)(parallel_task& task) noexcept;
+            std::atomic<bool> _done = false;
+        };
+
+        // Makes task available to other pool threads.  Off the pool, this does nothing, and
+        // parallel_join runs the task itself.
+        void parallel_fork(parallel_task& task);
+        // Returns once task has run, running it here if no other thread has taken it, and
+        // otherwise running other queued work while waiting.
+        void parallel_join(parallel_task& task) noexcept;
+        // Runs task on the pool and blocks until it completes.  From a pool thread, or if the pool
+        // has no threads, this runs task directly.
+        void parallel_execute(parallel_task& task);
+        // The number of threads available to run parallel work, at least 1.
+        unsigned parallel_concurrency() noexcept;
+
+        class thread_pool;
+
+        // While it exists, parallel work runs on a pool of its own with the given number of
+        // threads instead of the shared one, so that tests can exercise the parallel algorithms
+        // on any machine.  It must not be created or destroyed while parallel work is running.
+        class scoped_thread_pool
+        {
+        public:
+            explicit scoped_thread_pool(unsigned thread_count);
+            scoped_thread_pool(const scoped_thread_pool&) = delete;
+            scoped_thread_pool& operator = (const scoped_thread_pool&) = delete;
+            ~scoped_thread_pool();
+
+        private:
+            std::unique_ptr<thread_pool> _pool;
+            thread_pool* _previous;
+        };
+
+        template <typename Function>
+        class parallel_invocation final : public parallel_task
+        {
+        public:
+            explicit parallel_invocation(Function& f) noexcept : parallel_task(invoke), _f(f) { }
+
+        public:
+            void rethrow() const
+            {
+                if (_error)
+                    std::rethrow_exception(_error);
+            }
+
+        private:
+            static void invoke(parallel_task& task) noexcept
+            {
+                auto& self = static_cast<parallel_invocation&>(task);
+                try
+                {
+                    self._f();
+                }
+                catch (...)
+                {
+                    self._error = std::current_exception();
+                }
+            }
+
+        private:
+            Function& _f;
+            std::exception_ptr _error;
+        };
+
+        // Runs f on the pool, waiting for it to finish.
+        template <typename Function>
+        void parallel_run(Function&& f)
+        {
+            parallel_invocation<std::remove_reference_t<Function>> task(f);
+            parallel_execute(task);
+            task.rethrow();
+        }
+
+        // Runs f and g, potentially in parallel, and returns when both are done.  If either
+        // throws, the exception from f takes precedence.
+        template <typename Function1, typename Function2>
+        void parallel_invoke(Function1&& f, Function2&& g)
+        {
+            parallel_invocation<std::remove_reference_t<Function2>> task(g);
+            parallel_fork(task);
+
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                parallel_join(task);
+                throw;
+            }
+
+            parallel_join(task);
+            task.rethrow();
+        }
+
+        // Calls f(n) for each n in [first, last), potentially in parallel.
+        template <typename Function>
+        void parallel_for(size_t first, size_t last, Function&& f)
+        {
+            if (last - first > 1)
+            {
+                auto middle = first + (last - first) / 2;
+                parallel_invoke(
+                    [&] { parallel_for(first, middle, f); },
+                    [&] { parallel_for(middle, last, f); });
+            }
+            else if (first != last)
+                f(first);
+        }
+    }
+}
+
+#endif
@@ -15,6 +15,8 @@
 #include <stdext/stream.h>
 #include <stdext/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <system_error>
 
 
@@ -36,9 +38,26 @@ namespace stdext
 
     struct utf8_path_encoding { };
 
+    // Describes the expected access pattern for a memory-mapped file so that the operating
+    // system can tune read-ahead accordingly.
+    enum class mapped_file_access
+    {
+        normal,
+        sequential,
+        random
+    };
+
+    enum class mapped_file_flags
+    {
+        none = 0,
+        large_pages = 1     // Back the mapping with large pages where the platform supports it.
+    };
+
     class file_input_stream;
     class file_output_stream;
     class file_stream;
+    class mapped_file_input_stream;
+    class mapped_file_stream;
 
     namespace _private
     {
@@ -63,35 +82,179 @@ namespace stdext
             stream_position end_position() const override;
             void set_position(stream_position position) override;
 
+        protected:
+            size_t read_at_impl(stream_position position, byte* buffer, size_t size) const;
+            size_t write_at_impl(stream_position position, const byte* buffer, size_t size);
+
         protected:
             template <typename Stream> friend class file_input_stream_base;
             template <typename Stream> friend class file_output_stream_base;
 
             file_handle_t handle;
+
+#if STDEXT_PLATFORM_WINDOWS
+        private:
+            file_handle_t positional_handle(std::atomic<file_handle_t>& slot, unsigned long access) const;
+            void close_positional_handles() noexcept;
+
+            // Synchronous I/O on handle always advances its position, even with an explicit
+            // offset, so positional I/O goes through overlapped handles reopened on first use.
+            mutable std::atomic<file_handle_t> _read_handle = nullptr;
+            mutable std::atomic<file_handle_t> _write_handle = nullptr;
+#endif
         };
 
+        // Positional reads and writes address the file directly by offset, so multiple threads
+        // can share a single stream without coordinating.  They leave the stream position
+        // unchanged.
+
         template <typename Stream>
         class file_input_stream_base : public input_stream
         {
+        public:
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            [[nodiscard]] POD read_at(stream_position position) const
+            {
+                POD value;
+                if (self().read_at_impl(position, reinterpret_cast<byte*>(&value), sizeof(POD)) != sizeof(POD))
+                    throw stream_error("premature end of stream");
+                return value;
+            }
+
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            [[nodiscard]] size_t read_at(stream_position position, POD* buffer, size_t count) const
+            {
+                auto size = self().read_at_impl(position, reinterpret_cast<byte*>(buffer), count * sizeof(POD));
+                if (size % sizeof(POD) != 0)
+                    throw stream_error("premature end of stream");
+                return size / sizeof(POD);
+            }
+
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            void read_all_at(stream_position position, POD* buffer, size_t count) const
+            {
+                auto size = self().read_at_impl(position, reinterpret_cast<byte*>(buffer), count * sizeof(POD));
+                if (size != count * sizeof(POD))
+                    throw stream_error("premature end of stream");
+            }
+
+        protected:
+            // Must be called whenever the stream is attached to a different file.
+            void reset_skip_state() noexcept
+            {
+                _skip_mode = skip_mode::unknown;
+                _end_hint = 0;
+            }
+
         private:
             size_t do_read(byte* buffer, size_t size) override;
             size_t do_skip(size_t size) override;
+#if !STDEXT_PLATFORM_WINDOWS
+            size_t do_read_vectored(span<const span<byte>> buffers) override;
+#endif
+
+            size_t skip_by_reading(size_t size)
+            {
+                byte scratch[0x1000];
+                size_t bytes = 0;
+                while (size != 0)
+                {
+                    auto chunk = do_read(scratch, std::min(size, sizeof(scratch)));
+                    if (chunk == 0)
+                        break;
+
+                    bytes += chunk;
+                    size -= chunk;
+                }
+
+                return bytes;
+            }
 
         private:
             Stream& self() noexcept { return static_cast<Stream&>(*this); }
             const Stream& self() const noexcept { return static_cast<const Stream&>(*this); }
+
+        private:
+            enum class skip_mode : uint8_t
+            {
+                unknown,
+                seek,
+                read
+            };
+
+            // do_skip seeks when the file supports it and reads otherwise (e.g. for pipes).  When
+            // seeking, it only queries the file size again when a skip goes past the size that it
+            // last observed.
+            stream_position _end_hint = 0;
+            skip_mode _skip_mode = skip_mode::unknown;
         };
 
         template <typename Stream>
         class file_output_stream_base : public output_stream
         {
+        public:
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            void write_at(stream_position position, const POD& value)
+            {
+                if (self().write_at_impl(position, reinterpret_cast<const byte*>(&value), sizeof(POD)) != sizeof(POD))
+                    throw stream_error("premature end of stream");
+            }
+
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            [[nodiscard]] size_t write_at(stream_position position, const POD* buffer, size_t count)
+            {
+                auto size = self().write_at_impl(position, reinterpret_cast<const byte*>(buffer), count * sizeof(POD));
+                if (size % sizeof(POD) != 0)
+                    throw stream_error("premature end of stream");
+                return size / sizeof(POD);
+            }
+
+            template <typename POD, STDEXT_REQUIRES(std::is_trivially_copyable_v<POD>)>
+            void write_all_at(stream_position position, const POD* buffer, size_t count)
+            {
+                auto size = self().write_at_impl(position, reinterpret_cast<const byte*>(buffer), count * sizeof(POD));
+                if (size != count * sizeof(POD))
+                    throw stream_error("premature end of stream");
+            }
+
         private:
             size_t do_write(const byte* buffer, size_t size) override;
+#if !STDEXT_PLATFORM_WINDOWS
+            size_t do_write_vectored(span<const span<const byte>> buffers) override;
+#endif
 
         private:
             Stream& self() noexcept { return static_cast<Stream&>(*this); }
             const Stream& self() const noexcept { return static_cast<const Stream&>(*this); }
         };
+
+        class file_mapping
+        {
+        public:
+            file_mapping() noexcept = default;
+            file_mapping(const file_mapping&) = delete;
+            file_mapping& operator = (const file_mapping&) = delete;
+            file_mapping(file_mapping&& other) noexcept;
+            file_mapping& operator = (file_mapping&& other) noexcept;
+            ~file_mapping();
+
+        public:
+            std::error_code open(const path_char* path, bool writable, mapped_file_access access, flags<mapped_file_flags> flags);
+            std::error_code open(const char* path, utf8_path_encoding, bool writable, mapped_file_access access, flags<mapped_file_flags> flags);
+            bool is_open() const noexcept { return _open; }
+            void close() noexcept;
+
+            void advise(mapped_file_access access);
+            void flush();
+
+            byte* data() const noexcept { return _data; }
+            size_t size() const noexcept { return _size; }
+
+        private:
+            byte* _data = nullptr;
+            size_t _size = 0;
+            bool _open = false;
+        };
     }
 
     class file_input_stream : public _private::file_stream_base, public _private::file_input_stream_base<file_input_stream>
@@ -147,6 +310,86 @@ namespace stdext
         std::error_code open(const path_char* path, flags<file_open_flags> flags = default_flags);
         std::error_code open(const char* path, utf8_path_encoding, flags<file_open_flags> flags = default_flags);
     };
+
+    // Maps an entire file into memory for reading.  direct_read provides access to the mapped
+    // pages without copying.  The file's size is fixed when it is opened.
+    class mapped_file_input_stream : public memory_stream_base<const byte*>, public memory_input_stream_base<mapped_file_input_stream>, public input_stream
+    {
+    public:
+        mapped_file_input_stream() = default;
+        mapped_file_input_stream(mapped_file_input_stream&& other) noexcept;
+        mapped_file_input_stream& operator = (mapped_file_input_stream&& other) noexcept;
+        ~mapped_file_input_stream() override;
+
+        explicit mapped_file_input_stream(const path_char* path, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+        mapped_file_input_stream(const char* path, utf8_path_encoding, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+
+    public:
+        std::error_code open(const path_char* path, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+        std::error_code open(const char* path, utf8_path_encoding, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+
+        bool is_open() const noexcept { return _mapping.is_open(); }
+        void close() noexcept;
+
+        void advise(mapped_file_access access) { _mapping.advise(access); }
+
+    private:
+        [[nodiscard]] size_t do_read(byte* buffer, size_t size) final
+        {
+            return read_impl(buffer, size);
+        }
+
+        [[nodiscard]] size_t do_skip(size_t size) final
+        {
+            return skip_impl(size);
+        }
+
+    private:
+        _private::file_mapping _mapping;
+    };
+
+    // Maps an entire existing file into memory for reading and writing.  Writes go directly to
+    // the mapped pages and cannot extend the file; flush commits modified pages to storage.
+    class mapped_file_stream : public memory_stream_base<byte*>, public memory_input_stream_base<mapped_file_stream>, public memory_output_stream_base<mapped_file_stream>, public stream
+    {
+    public:
+        mapped_file_stream() = default;
+        mapped_file_stream(mapped_file_stream&& other) noexcept;
+        mapped_file_stream& operator = (mapped_file_stream&& other) noexcept;
+        ~mapped_file_stream() override;
+
+        explicit mapped_file_stream(const path_char* path, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+        mapped_file_stream(const char* path, utf8_path_encoding, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+
+    public:
+        std::error_code open(const path_char* path, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+        std::error_code open(const char* path, utf8_path_encoding, mapped_file_access access = mapped_file_access::normal, flags<mapped_file_flags> flags = mapped_file_flags::none);
+
+        bool is_open() const noexcept { return _mapping.is_open(); }
+        void close() noexcept;
+
+        void advise(mapped_file_access access) { _mapping.advise(access); }
+        void flush() { _mapping.flush(); }
+
+    private:
+        [[nodiscard]] size_t do_read(byte* buffer, size_t size) final
+        {
+            return read_impl(buffer, size);
+        }
+
+        [[nodiscard]] size_t do_write(const byte* buffer, size_t size) final
+        {
+            return write_impl(buffer, size);
+        }
+
+        [[nodiscard]] size_t do_skip(size_t size) final
+        {
+            return skip_impl(size);
+        }
+
+    private:
+        _private::file_mapping _mapping;
+    };
 }
 
 #endif
@@ -14,16 +14,19 @@
 #include <stdext/flags.h>
 #include <stdext/generator.h>
 #include <stdext/meta.h>
+#include <stdext/span.h>
 #include <stdext/string.h>
 #include <stdext/string_view.h>
 
 #include <algorithm>
 #include <array>
 #include <functional>
+#include <limits>
 #include <stdexcept>
 
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 
 
 namespace stdext
@@ -34,8 +37,38 @@ namespace stdext
     template <typename... Args>
     std::string format_string(string_view fmt, Args&&... args);
 
+    // The number of characters format_string would produce.
+    template <typename... Args>
+    size_t formatted_size(string_view fmt, Args&&... args);
+
+    // Formats into buffer without allocating, and returns the size of the whole result.  If that
+    // is more than buffer.size(), only the first buffer.size() characters are written.
+    template <typename... Args>
+    size_t format_to(span<char> buffer, string_view fmt, Args&&... args);
+
+    template <typename Source> struct format_pattern;
+
+    template <typename Consumer, typename Source, typename... Args, STDEXT_REQUIRES(is_consumer_v<std::decay_t<Consumer>, char>)>
+    bool format(Consumer&& out, format_pattern<Source> fmt, Args&&... args);
+
+    template <typename Source, typename... Args>
+    std::string format_string(format_pattern<Source> fmt, Args&&... args);
+
+    template <typename Source, typename... Args>
+    size_t formatted_size(format_pattern<Source> fmt, Args&&... args);
+
+    template <typename Source, typename... Args>
+    size_t format_to(span<char> buffer, format_pattern<Source> fmt, Args&&... args);
+
     template <typename Consumer, typename Arg, STDEXT_REQUIRES(is_consumer_v<Consumer, char> && std::is_integral_v<Arg>)>
     bool format_arg(Consumer& out, string_view fmt, Arg arg);
+    // The spec is printf-style flags, width, precision, and one of e, f, or g (or E, F, or G for
+    // uppercase).  Without a precision, the digits are the shortest that read back as the same
+    // value: e is scientific, f is fixed, and g or no type at all picks whichever is shorter.
+    // Like std::to_chars, fixed notation still shows every digit of a large integer exactly.
+    // With a precision, the value is rounded exactly, as by printf; no type then means g.
+    template <typename Consumer, typename Arg, STDEXT_REQUIRES(is_consumer_v<Consumer, char> && (std::is_same_v<Arg, float> || std::is_same_v<Arg, double>))>
+    bool format_arg(Consumer& out, string_view fmt, Arg arg);
 
     template <typename Consumer, typename Arg, STDEXT_REQUIRES(is_consumer_v<Consumer, char> && std::is_convertible_v<std::decay_t<Arg>, string_view>)>
     bool format_arg(Consumer& out, string_view fmt, Arg&& arg);
@@ -83,6 +116,86 @@ namespace stdext
         }
     }
 
+    namespace _private
+    {
+        // Counts characters without storing them.
+        class format_counter
+        {
+        public:
+            bool operator () (char) noexcept
+            {
+                ++_size;
+                return true;
+            }
+
+            bool operator () (string_view str) noexcept
+            {
+                _size += str.size();
+                return true;
+            }
+
+            size_t size() const noexcept { return _size; }
+
+        private:
+            size_t _size = 0;
+        };
+
+        // Writes to a fixed buffer, counting whatever doesn't fit.
+        class format_buffer
+        {
+        public:
+            explicit format_buffer(span<char> buffer) noexcept : _data(buffer.data()), _capacity(buffer.size()) { }
+
+        public:
+            bool operator () (char c) noexcept
+            {
+                if (_size < _capacity)
+                    _data[_size] = c;
+                ++_size;
+                return true;
+            }
+
+            bool operator () (string_view str) noexcept
+            {
+                if (_size < _capacity)
+                    std::memcpy(_data + _size, str.data(), std::min(str.size(), _capacity - _size));
+                _size += str.size();
+                return true;
+            }
+
+            size_t size() const noexcept { return _size; }
+
+        private:
+            char* _data;
+            size_t _capacity;
+            size_t _size = 0;
+        };
+
+        // Invocable arguments may accept only the consumer they're given, and may not expect to
+        // be called twice, so format_string measures first only when there are none.
+        template <typename... Args>
+        constexpr bool format_args_are_values_v = (... && !(std::is_invocable_v<Args, stringbuf&> || std::is_invocable_v<Args, stringbuf&, string_view>));
+
+        template <typename Format, typename... Args>
+        std::string format_string(Format fmt, Args&&... args)
+        {
+            if constexpr (format_args_are_values_v<Args...>)
+            {
+                std::string str(formatted_size(fmt, args...), '\0');
+                format_to(str, fmt, args...);
+                return str;
+            }
+            else
+            {
+                stringbuf buf;
+                bool result = format(buf, fmt, stdext::forward<Args>(args)...);
+                assert(result);
+                discard(result);
+                return buf.extract();
+            }
+        }
+    }
+
     template <typename Consumer, typename... Args, STDEXT_REQUIRED(is_consumer_v<std::decay_t<Consumer>, char>)>
     bool format(Consumer&& out, string_view fmt, Args&&... args)
     {
@@ -147,11 +260,284 @@ namespace stdext
     template <typename... Args>
     std::string format_string(string_view fmt, Args&&... args)
     {
-        stringbuf buf;
-        bool result = format(buf, fmt, stdext::forward<Args>(args)...);
-        assert(result);
-        discard(result);
-        return buf.extract();
+        return _private::format_string(fmt, stdext::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    size_t formatted_size(string_view fmt, Args&&... args)
+    {
+        _private::format_counter counter;
+        format(counter, fmt, stdext::forward<Args>(args)...);
+        return counter.size();
+    }
+
+    template <typename... Args>
+    size_t format_to(span<char> buffer, string_view fmt, Args&&... args)
+    {
+        _private::format_buffer out(buffer);
+        format(out, fmt, stdext::forward<Args>(args)...);
+        return out.size();
+    }
+
+    // A format string parsed when compiling; create one with STDEXT_FORMAT.  Formatting with it
+    // produces the same output as the equivalent runtime format string, but each run of literal
+    // text and each argument reference is handled by its own straight-line code, and an argument
+    // index out of range or a spec the argument's type can't accept is a compile-time error.
+    // Source supplies the string through static constexpr data() and size() functions.
+    template <typename Source>
+    struct format_pattern
+    {
+        static string_view str() noexcept { return string_view(Source::data(), Source::size()); }
+    };
+
+    namespace _private
+    {
+        template <size_t N>
+        constexpr size_t format_literal_length(const char (&)[N]) noexcept
+        {
+            return N - 1;
+        }
+
+        struct format_segment
+        {
+            static constexpr size_t literal = size_t(-1);
+
+            size_t offset = 0;              // The literal text, or the argument's spec.
+            size_t length = 0;
+            size_t index = literal;
+        };
+
+        constexpr bool format_is_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        // Parses the same syntax as format, calling visit with each segment in turn.
+        template <typename Visitor>
+        constexpr void parse_format(const char* fmt, size_t size, Visitor&& visit)
+        {
+            size_t i = 0, literal = 0;
+            auto flush = [&](size_t end)
+            {
+                if (end != literal)
+                    visit(format_segment{ literal, end - literal, format_segment::literal });
+            };
+
+            while (i != size)
+            {
+                if (fmt[i] != '$')
+                {
+                    ++i;
+                    continue;
+                }
+
+                flush(i);
+                if (++i == size)
+                    throw format_error("Invalid format string");
+
+                if (fmt[i] == '$')
+                {
+                    // The second $ starts the next run of literal text.
+                    literal = i++;
+                    continue;
+                }
+
+                bool braced = fmt[i] == '{';
+                if (braced)
+                    ++i;
+                if (i == size || !format_is_digit(fmt[i]))
+                    throw format_error("Invalid format string");
+
+                size_t index = 0;
+                for (; i != size && format_is_digit(fmt[i]); ++i)
+                    index = 10 * index + size_t(fmt[i] - '0');
+
+                format_segment segment = { i, 0, index };
+                if (braced)
+                {
+                    if (i != size && fmt[i] == ':')
+                    {
+                        segment.offset = ++i;
+                        while (i != size && fmt[i] != '}')
+                            ++i;
+                        segment.length = i - segment.offset;
+                    }
+                    if (i == size || fmt[i] != '}')
+                        throw format_error("Invalid format string");
+                    ++i;
+                }
+
+                visit(segment);
+                literal = i;
+            }
+
+            flush(size);
+        }
+
+        template <typename Source>
+        struct format_segments
+        {
+            static constexpr size_t count = []
+            {
+                size_t n = 0;
+                parse_format(Source::data(), Source::size(), [&](const format_segment&) { ++n; });
+                return n;
+            }();
+
+            static constexpr std::array<format_segment, count> value = []
+            {
+                std::array<format_segment, count> segments = { };
+                size_t n = 0;
+                parse_format(Source::data(), Source::size(), [&](const format_segment& segment) { segments[n++] = segment; });
+                return segments;
+            }();
+        };
+
+        // Checks a spec against what format_integer accepts: flags, then a width, then (except
+        // for characters) a precision and a conversion specifier.
+        constexpr bool format_integer_spec_is_valid(const char* spec, size_t size, bool character) noexcept
+        {
+            size_t i = 0;
+            auto is_flag = [](char c) { return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0'; };
+            while (i != size && is_flag(spec[i]))
+                ++i;
+            while (i != size && format_is_digit(spec[i]))
+                ++i;
+            if (character)
+                return i == size;
+
+            if (i != size && spec[i] == '.')
+            {
+                if (++i == size || !format_is_digit(spec[i]))
+                    return false;
+                while (i != size && format_is_digit(spec[i]))
+                    ++i;
+            }
+
+            auto is_specifier = [](char c) { return c == 'b' || c == 'B' || c == 'd' || c == 'o' || c == 'x' || c == 'X'; };
+            if (i != size && is_specifier(spec[i]))
+                ++i;
+            return i == size;
+        }
+
+        // Checks a spec against what format_float accepts: flags, a width, a precision, and a
+        // conversion specifier, each optional.
+        constexpr bool format_float_spec_is_valid(const char* spec, size_t size) noexcept
+        {
+            size_t i = 0;
+            auto is_flag = [](char c) { return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0'; };
+            while (i != size && is_flag(spec[i]))
+                ++i;
+            while (i != size && format_is_digit(spec[i]))
+                ++i;
+
+            if (i != size && spec[i] == '.')
+            {
+                if (++i == size || !format_is_digit(spec[i]))
+                    return false;
+                while (i != size && format_is_digit(spec[i]))
+                    ++i;
+            }
+
+            auto is_specifier = [](char c) { return c == 'e' || c == 'E' || c == 'f' || c == 'F' || c == 'g' || c == 'G'; };
+            if (i != size && is_specifier(spec[i]))
+                ++i;
+            return i == size;
+        }
+
+        template <typename Arg>
+        constexpr bool format_is_character_v = std::is_same_v<Arg, char>
+#if STDEXT_HAS_C_UNICODE
+            || std::is_same_v<Arg, char16_t> || std::is_same_v<Arg, char32_t>
+#endif
+            || std::is_same_v<Arg, wchar_t>;
+
+        // The string and nullary invocable overloads of format_arg reject any spec.  Any other
+        // argument's format_arg is left to check the spec at run time.
+        template <typename Arg, typename Consumer>
+        constexpr bool format_rejects_spec_v = std::is_convertible_v<std::decay_t<Arg>, string_view>
+#if STDEXT_HAS_C_UNICODE
+            || std::is_convertible_v<std::decay_t<Arg>, u16string_view> || std::is_convertible_v<std::decay_t<Arg>, u32string_view>
+#endif
+            || std::is_convertible_v<std::decay_t<Arg>, wstring_view>
+            || (std::is_invocable_r_v<bool, Arg, Consumer&> && !std::is_invocable_r_v<bool, Arg, Consumer&, string_view>);
+
+        template <typename Source, size_t I, typename Consumer, typename ArgsTuple, typename... Args>
+        bool format_segment_at(Consumer& out, const ArgsTuple& args, type_list<Args...>)
+        {
+            constexpr auto segment = format_segments<Source>::value[I];
+            constexpr auto text = Source::data() + segment.offset;
+
+            if constexpr (segment.index == format_segment::literal)
+            {
+                string_view sv(text, segment.length);
+                if constexpr (is_consumer_v<std::decay_t<Consumer>, string_view>)
+                    return out(sv);
+                else
+                    return sv >> out;
+            }
+            else
+            {
+                static_assert(segment.index < sizeof...(Args), "Argument index out of range");
+
+                using arg_type = list_element_t<type_list<Args...>, segment.index>;
+                using value_type = std::decay_t<arg_type>;
+                if constexpr (std::is_integral_v<value_type>)
+                    static_assert(format_integer_spec_is_valid(text, segment.length, format_is_character_v<value_type>), "Invalid format spec for integral argument");
+                else if constexpr (std::is_floating_point_v<value_type>)
+                    static_assert(format_float_spec_is_valid(text, segment.length), "Invalid format spec for floating-point argument");
+                else if constexpr (format_rejects_spec_v<arg_type, Consumer>)
+                    static_assert(segment.length == 0, "Argument does not accept a format spec");
+
+                return format_arg(out, string_view(text, segment.length), stdext::forward<arg_type>(std::get<segment.index>(args)));
+            }
+        }
+
+        template <typename Source, size_t... Indices, typename Consumer, typename ArgsTuple, typename... Args>
+        bool format_pattern_segments(std::index_sequence<Indices...>, Consumer& out, const ArgsTuple& args, type_list<Args...>)
+        {
+            return (... && format_segment_at<Source, Indices>(out, args, type_list<Args...>()));
+        }
+    }
+
+#define STDEXT_FORMAT(fmt) \
+    ([] \
+    { \
+        struct source \
+        { \
+            static constexpr const char* data() noexcept { return fmt; } \
+            static constexpr size_t size() noexcept { return ::stdext::_private::format_literal_length(fmt); } \
+        }; \
+        return ::stdext::format_pattern<source>(); \
+    }())
+
+    template <typename Consumer, typename Source, typename... Args, STDEXT_REQUIRED(is_consumer_v<std::decay_t<Consumer>, char>)>
+    bool format(Consumer&& out, format_pattern<Source>, Args&&... args)
+    {
+        std::tuple<Args&...> arglist = { args... };
+        return _private::format_pattern_segments<Source>(std::make_index_sequence<_private::format_segments<Source>::count>(), out, arglist, type_list<Args...>());
+    }
+
+    template <typename Source, typename... Args>
+    std::string format_string(format_pattern<Source> fmt, Args&&... args)
+    {
+        return _private::format_string(fmt, stdext::forward<Args>(args)...);
+    }
+
+    template <typename Source, typename... Args>
+    size_t formatted_size(format_pattern<Source> fmt, Args&&... args)
+    {
+        _private::format_counter counter;
+        format(counter, fmt, stdext::forward<Args>(args)...);
+        return counter.size();
+    }
+
+    template <typename Source, typename... Args>
+    size_t format_to(span<char> buffer, format_pattern<Source> fmt, Args&&... args)
+    {
+        _private::format_buffer out(buffer);
+        format(out, fmt, stdext::forward<Args>(args)...);
+        return out.size();
     }
 
     namespace _private
@@ -179,7 +565,81 @@ namespace stdext
         };
 
         flags<format_options> parse_format_options(string_view& fmt);
-        bool format_integer(const std::function<bool (char ch)>& out, string_view fmt, uintmax_t uval, format_type type);
+
+        // A formatted integer, laid out as left padding, sign and radix prefix, zeros required
+        // by the precision, digits, and right padding.  For the character types, only the
+        // padding is filled in; the character itself goes between.
+        struct integer_field
+        {
+            static constexpr size_t max_digits = std::numeric_limits<uintmax_t>::digits;
+
+            size_t left_pad = 0;
+            size_t right_pad = 0;
+            size_t zeros = 0;
+            size_t head_size = 0;
+            size_t digits_size = 0;
+            char pad = ' ';
+            char head[3] = { };
+            char digits[max_digits] = { };      // The digits occupy the end of the array.
+
+            size_t size() const noexcept { return left_pad + head_size + zeros + digits_size + right_pad; }
+            // Writes size() characters to out and returns the end.
+            char* write(char* out) const noexcept;
+        };
+
+        integer_field format_integer(string_view fmt, uintmax_t uval, format_type type);
+
+        // Formats value into out if the whole field fits in capacity characters, and returns its
+        // size either way.
+        size_t format_float(char* out, size_t capacity, string_view fmt, float value);
+        size_t format_float(char* out, size_t capacity, string_view fmt, double value);
+
+        template <typename Consumer>
+        bool format_write(Consumer& out, const char* p, size_t size)
+        {
+            if constexpr (is_consumer_v<std::decay_t<Consumer>, string_view>)
+                return out(string_view(p, size));
+            else
+            {
+                for (size_t n = 0; n != size; ++n)
+                {
+                    if (!out(p[n]))
+                        return false;
+                }
+                return true;
+            }
+        }
+
+        template <typename Consumer>
+        bool format_write_padding(Consumer& out, size_t count)
+        {
+            static constexpr char spaces[] = "                                ";
+            for (; count > std::size(spaces) - 1; count -= std::size(spaces) - 1)
+            {
+                if (!format_write(out, spaces, std::size(spaces) - 1))
+                    return false;
+            }
+            return format_write(out, spaces, count);
+        }
+
+        // Formats the whole field into one buffer, so that it reaches the consumer in a single
+        // call if the consumer accepts string_view.
+        template <typename Consumer>
+        bool format_write(Consumer& out, const integer_field& field)
+        {
+            constexpr size_t buffer_size = 128;
+            auto size = field.size();
+            if (size <= buffer_size)
+            {
+                char buffer[buffer_size];
+                field.write(buffer);
+                return format_write(out, buffer, size);
+            }
+
+            std::string buffer(size, '\0');
+            field.write(buffer.data());
+            return format_write(out, buffer.data(), size);
+        }
     }
 
     template <typename Consumer, typename Arg, STDEXT_REQUIRED(is_consumer_v<Consumer, char> && std::is_integral_v<Arg>)>
@@ -193,7 +653,42 @@ namespace stdext
             : std::is_same_v<Arg, wchar_t> ? _private::format_type::_wchar
             : std::is_signed_v<Arg> ? _private::format_type::_signed
             : _private::format_type::_unsigned;
-        return _private::format_integer(std::ref(out), fmt, arg, type);
+        auto field = _private::format_integer(fmt, uintmax_t(arg), type);
+        if constexpr (!_private::format_is_character_v<Arg>)
+            return _private::format_write(out, field);
+        else
+        {
+            if (!_private::format_write_padding(out, field.left_pad))
+                return false;
+
+            if constexpr (std::is_same_v<Arg, char>)
+            {
+                if (!out(arg))
+                    return false;
+            }
+            else
+            {
+                // Other characters are converted to the narrow encoding, as strings are.
+                if (!format_arg(out, string_view(), basic_string_view<Arg>(&arg, 1)))
+                    return false;
+            }
+
+            return _private::format_write_padding(out, field.right_pad);
+        }
+    }
+
+    template <typename Consumer, typename Arg, STDEXT_REQUIRED(is_consumer_v<Consumer, char> && (std::is_same_v<Arg, float> || std::is_same_v<Arg, double>))>
+    bool format_arg(Consumer& out, string_view fmt, Arg arg)
+    {
+        constexpr size_t buffer_size = 128;
+        char buffer[buffer_size];
+        auto size = _private::format_float(buffer, buffer_size, fmt, arg);
+        if (size <= buffer_size)
+            return _private::format_write(out, buffer, size);
+
+        std::string large(size, '\0');
+        _private::format_float(large.data(), size, fmt, arg);
+        return _private::format_write(out, large.data(), size);
     }
 
     template <typename Consumer, typename Arg, STDEXT_REQUIRED(is_consumer_v<Consumer, char> && std::is_convertible_v<std::decay_t<Arg>, string_view>)>
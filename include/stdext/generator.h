@@ -67,6 +67,22 @@ namespace stdext
     template <typename T> using generator_value_type = typename generator_traits<T>::value_type;
     template <typename T> using generator_reference_type = typename generator_traits<T>::reference;
 
+    // A generator may also expose upcoming elements in bulk: g.chunk() returns a
+    // span<const value_type> beginning with *g, or an empty span if there is none to offer, and
+    // g.advance(n) moves past the first n elements of it.  operator >> hands these chunks to
+    // consumers that accept them.
+    namespace _private
+    {
+        template <typename X>
+        std::conjunction<
+            std::is_convertible<decltype(declval<const X&>().chunk()), span<const generator_value_type<X>>>,
+            std::is_void<decltype(declval<X&>().advance(size_t()))>>
+        test_is_chunked_generator(int);
+        template <typename X> false_type test_is_chunked_generator(...);
+    }
+    template <typename T> struct is_chunked_generator : decltype(_private::test_is_chunked_generator<T>(0)) { };
+    template <typename T> constexpr auto is_chunked_generator_v = is_chunked_generator<T>::value;
+
     template <typename Iterator, typename Sentinel = Iterator>
     class delimited_iterator_generator
     {
@@ -107,6 +123,12 @@ namespace stdext
         reference operator * () const { assert(_i != _j); return *_i; }
         delimited_iterator_generator& operator ++ () { assert(_i != _j); ++_i; return *this; }
         explicit operator bool () const { return _i != _j; }
+
+        template <typename I = iterator, STDEXT_REQUIRES(std::is_pointer_v<I> && std::is_same_v<I, sentinel>)>
+        span<const value_type> chunk() const noexcept { return { _i, size_t(_j - _i) }; }
+        template <typename I = iterator, STDEXT_REQUIRES(std::is_pointer_v<I> && std::is_same_v<I, sentinel>)>
+        void advance(size_t n) noexcept { assert(n <= size_t(_j - _i)); _i += n; }
+
         const iterator& base() const noexcept { return _i; }
         const sentinel& end() const noexcept { return _j; }
 
@@ -153,6 +175,12 @@ namespace stdext
         reference operator * () const { assert(_n != 0); return *_i; }
         counted_iterator_generator& operator ++ () { assert(_n != 0); ++_i; --_n; return *this; }
         explicit operator bool () const noexcept { return _n != 0; }
+
+        template <typename I = iterator, STDEXT_REQUIRES(std::is_pointer_v<I>)>
+        span<const value_type> chunk() const noexcept { return { _i, size_t(_n) }; }
+        template <typename I = iterator, STDEXT_REQUIRES(std::is_pointer_v<I>)>
+        void advance(size_t n) noexcept { assert(n <= size_t(_n)); _i += n; _n -= size_type(n); }
+
         const iterator& base() const noexcept { return _i; }
         size_type count() const noexcept { return _n; }
 
@@ -354,10 +382,29 @@ template <typename Producer, typename Consumer,
     STDEXT_REQUIRES(stdext::can_generate_v<Producer> && stdext::is_consumer_v<stdext::remove_cvref_t<Consumer>, stdext::generator_value_type<stdext::generator_type<Producer>>>)>
 bool operator >> (Producer&& p, Consumer&& c)
 {
-    for (auto&& gen = stdext::as_generator(stdext::forward<Producer>(p)); gen; ++gen)
+    using generator = stdext::generator_type<Producer>;
+    constexpr bool chunked = stdext::is_chunked_generator_v<generator>
+        && stdext::is_chunk_consumer_v<stdext::remove_cvref_t<Consumer>, stdext::generator_value_type<generator>>;
+
+    auto&& gen = stdext::as_generator(stdext::forward<Producer>(p));
+    while (gen)
     {
+        if constexpr (chunked)
+        {
+            auto chunk = gen.chunk();
+            if (!chunk.empty())
+            {
+                auto count = c(chunk);
+                gen.advance(count);
+                if (count != chunk.size())
+                    return false;
+                continue;
+            }
+        }
+
         if (!c(*gen))
             return false;
+        ++gen;
     }
 
     return true;
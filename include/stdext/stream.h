@@ -11,10 +11,14 @@
 #pragma once
 
 #include <stdext/generator.h>
+#include <stdext/span.h>
 #include <stdext/string_view.h>
+#include <stdext/utility.h>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <stdexcept>
 
 
@@ -50,9 +54,16 @@ namespace stdext
     class memory_input_stream;
     class memory_output_stream;
     class memory_stream;
+    template <typename Allocator = std::allocator<byte>> class dynamic_memory_output_stream;
 
     class substream;
 
+    class buffered_input_stream;
+    class buffered_output_stream;
+
+    class memory_segment_pool;
+    class segmented_memory_stream;
+
     input_stream& in();
     output_stream& out();
     output_stream& err();
@@ -140,9 +151,26 @@ namespace stdext
                 throw stream_error("premature end of stream");
         }
 
+        // Fills each buffer in turn, stopping early only at the end of the stream.  Returns the
+        // total number of bytes read.
+        [[nodiscard]] size_t read_vectored(span<const span<byte>> buffers)
+        {
+            return do_read_vectored(buffers);
+        }
+
+        void read_all_vectored(span<const span<byte>> buffers)
+        {
+            size_t expected = 0;
+            for (auto& buffer : buffers)
+                expected += buffer.size();
+            if (do_read_vectored(buffers) != expected)
+                throw stream_error("premature end of stream");
+        }
+
     private:
         [[nodiscard]] virtual size_t do_read(byte* buffer, size_t size) = 0;
         [[nodiscard]] virtual size_t do_skip(size_t size) = 0;
+        [[nodiscard]] virtual size_t do_read_vectored(span<const span<byte>> buffers);
     };
 
 
@@ -188,8 +216,25 @@ namespace stdext
             write_all(buffer, Length);
         }
 
+        // Writes each buffer in turn, stopping early only if the stream is full.  Returns the
+        // total number of bytes written.
+        [[nodiscard]] size_t write_vectored(span<const span<const byte>> buffers)
+        {
+            return do_write_vectored(buffers);
+        }
+
+        void write_all_vectored(span<const span<const byte>> buffers)
+        {
+            size_t expected = 0;
+            for (auto& buffer : buffers)
+                expected += buffer.size();
+            if (do_write_vectored(buffers) != expected)
+                throw stream_error("premature end of stream");
+        }
+
     private:
         [[nodiscard]] virtual size_t do_write(const byte* buffer, size_t size) = 0;
+        [[nodiscard]] virtual size_t do_write_vectored(span<const span<const byte>> buffers);
     };
 
     class stream : public input_stream, public output_stream
@@ -361,6 +406,9 @@ namespace stdext
     };
 
 
+    // For a stream of bytes that can be read in place, the current element is left in the stream
+    // until the generator moves past it, and the rest of the stream's buffer is offered as a
+    // chunk.
     template <typename POD>
     class stream_generator
     {
@@ -374,9 +422,11 @@ namespace stdext
         using reference = const value_type&;
 
     public:
-        stream_generator() noexcept : _stream(), _value() { }
-        explicit stream_generator(input_stream& stream) noexcept : _stream(&stream)
+        stream_generator() noexcept : _stream(), _direct(), _value() { }
+        explicit stream_generator(input_stream& stream) noexcept : _stream(&stream), _direct()
         {
+            if constexpr (sizeof(POD) == 1)
+                _direct = dynamic_cast<direct_readable*>(&stream);
             next();
         }
 
@@ -393,26 +443,68 @@ namespace stdext
         friend void swap(stream_generator& a, stream_generator& b) noexcept
         {
             swap(a._stream, b._stream);
+            swap(a._direct, b._direct);
             swap(a._value, b._value);
         }
 
     public:
         reference operator * () const noexcept { return _value; }
-        stream_generator& operator ++ () { next(); return *this; }
+        stream_generator& operator ++ () { advance(1); return *this; }
         explicit operator bool () const noexcept { return _stream != nullptr; }
 
+        span<const value_type> chunk() const
+        {
+            span<const value_type> result;
+            if (_direct != nullptr)
+            {
+                discard(_direct->direct_read([&](const byte* buffer, size_t size)
+                {
+                    result = { reinterpret_cast<const value_type*>(buffer), size };
+                    return size_t(0);
+                }));
+            }
+            return result;
+        }
+
+        void advance(size_t n)
+        {
+            assert(n == 1 || _direct != nullptr);
+            if (_direct != nullptr)
+                discard(_direct->direct_read([n](const byte*, size_t) { return n; }));
+            next();
+        }
+
     private:
         void next()
         {
-            if (_stream->read(&_value, 1) == 0)
+            bool valid;
+            if (_direct != nullptr)
+            {
+                valid = false;
+                discard(_direct->direct_read([&](const byte* buffer, size_t size)
+                {
+                    if (size != 0)
+                    {
+                        std::memcpy(&_value, buffer, 1);
+                        valid = true;
+                    }
+                    return size_t(0);
+                }));
+            }
+            else
+                valid = _stream->read(&_value, 1) != 0;
+
+            if (!valid)
             {
                 _stream = nullptr;
+                _direct = nullptr;
                 _value = POD();
             }
         }
 
     private:
         input_stream* _stream;
+        direct_readable* _direct;
         POD _value;
     };
 
@@ -445,6 +537,11 @@ namespace stdext
             return _stream->write(&value, 1) != 0;
         }
 
+        [[nodiscard]] size_t operator () (span<const value_type> values)
+        {
+            return _stream->write(values.data(), values.size());
+        }
+
     private:
         output_stream* _stream;
     };
@@ -690,6 +787,208 @@ namespace stdext
         }
     };
 
+    // A memory output stream that owns its buffer and grows it geometrically as needed, so that
+    // writes are never truncated.  The end position is the furthest extent written; seeking back
+    // and writing again overwrites existing data.  extract hands over the buffer without copying.
+    template <typename Allocator>
+    class dynamic_memory_output_stream : public seekable, public direct_writable, public output_stream
+    {
+        static_assert(std::is_same_v<typename std::allocator_traits<Allocator>::value_type, byte>);
+
+    private:
+        using allocator_traits = std::allocator_traits<Allocator>;
+
+    public:
+        static constexpr size_t minimum_capacity = 0x40;
+
+        class deleter
+        {
+        public:
+            deleter() = default;
+            deleter(const Allocator& allocator, size_t capacity) noexcept : _allocator(allocator), _capacity(capacity) { }
+
+        public:
+            void operator () (byte* buffer) noexcept { allocator_traits::deallocate(_allocator, buffer, _capacity); }
+
+        private:
+            Allocator _allocator;
+            size_t _capacity = 0;
+        };
+
+        using buffer_ptr = std::unique_ptr<byte[], deleter>;
+
+    public:
+        dynamic_memory_output_stream() = default;
+        dynamic_memory_output_stream(const dynamic_memory_output_stream&) = delete;
+        dynamic_memory_output_stream& operator = (const dynamic_memory_output_stream&) = delete;
+
+        dynamic_memory_output_stream(dynamic_memory_output_stream&& other) noexcept
+            : _allocator(stdext::move(other._allocator)),
+            _buffer(stdext::exchange(other._buffer, nullptr)),
+            _capacity(stdext::exchange(other._capacity, 0)),
+            _size(stdext::exchange(other._size, 0)),
+            _position(stdext::exchange(other._position, 0))
+        {
+        }
+
+        dynamic_memory_output_stream& operator = (dynamic_memory_output_stream&& other)
+            noexcept(allocator_traits::propagate_on_container_move_assignment::value || allocator_traits::is_always_equal::value)
+        {
+            if (this == &other)
+                return *this;
+
+            if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+            {
+                deallocate();
+                _allocator = stdext::move(other._allocator);
+                take(other);
+            }
+            else if (allocator_traits::is_always_equal::value || _allocator == other._allocator)
+            {
+                deallocate();
+                take(other);
+            }
+            else
+            {
+                // The other buffer can't be released through our allocator, so copy its contents.
+                clear();
+                reserve(other._size);
+                std::copy_n(other._buffer, other._size, _buffer);
+                _size = other._size;
+                _position = other._position;
+                other.clear();
+            }
+
+            return *this;
+        }
+
+        explicit dynamic_memory_output_stream(const Allocator& allocator) noexcept
+            : _allocator(allocator)
+        {
+        }
+
+        explicit dynamic_memory_output_stream(size_t capacity, const Allocator& allocator = Allocator())
+            : _allocator(allocator)
+        {
+            reserve(capacity);
+        }
+
+        ~dynamic_memory_output_stream() override
+        {
+            deallocate();
+        }
+
+    public:
+        Allocator get_allocator() const noexcept { return _allocator; }
+
+        const byte* data() const noexcept { return _buffer; }
+        size_t size() const noexcept { return _size; }
+        size_t capacity() const noexcept { return _capacity; }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > _capacity)
+                reallocate(capacity);
+        }
+
+        // Discards the contents of the stream without releasing the buffer.
+        void clear() noexcept
+        {
+            _size = _position = 0;
+        }
+
+        // Releases ownership of the buffer along with the number of bytes written to it.  The
+        // stream is left empty.
+        [[nodiscard]] std::pair<buffer_ptr, size_t> extract() noexcept
+        {
+            buffer_ptr buffer(stdext::exchange(_buffer, nullptr), deleter(_allocator, stdext::exchange(_capacity, 0)));
+            auto size = stdext::exchange(_size, 0);
+            _position = 0;
+            return { stdext::move(buffer), size };
+        }
+
+    public:
+        stream_position position() const final
+        {
+            return _position;
+        }
+
+        stream_position end_position() const final
+        {
+            return _size;
+        }
+
+        void set_position(stream_position position) final
+        {
+            if (position > _size)
+                throw std::invalid_argument("position out of range");
+
+            _position = size_t(position);
+        }
+
+        // Offers the remainder of the current buffer, growing it first if it is full.
+        [[nodiscard]] size_t direct_write(std::function<size_t (byte* buffer, size_t size)> write) final
+        {
+            if (_position == _capacity)
+                grow(_capacity + 1);
+
+            auto size = write(_buffer + _position, _capacity - _position);
+            _position += size;
+            _size = std::max(_size, _position);
+            return size;
+        }
+
+    private:
+        [[nodiscard]] size_t do_write(const byte* buffer, size_t size) final
+        {
+            if (size > _capacity - _position)
+                grow(_position + size);
+
+            std::copy_n(buffer, size, _buffer + _position);
+            _position += size;
+            _size = std::max(_size, _position);
+            return size;
+        }
+
+        void grow(size_t required)
+        {
+            if (required < _position)
+                throw std::length_error("dynamic_memory_output_stream too large");
+
+            reallocate(std::max({ required, _capacity + _capacity / 2, minimum_capacity }));
+        }
+
+        void reallocate(size_t capacity)
+        {
+            auto buffer = allocator_traits::allocate(_allocator, capacity);
+            std::copy_n(_buffer, _size, buffer);
+            deallocate();
+            _buffer = buffer;
+            _capacity = capacity;
+        }
+
+        void deallocate() noexcept
+        {
+            if (_buffer != nullptr)
+                allocator_traits::deallocate(_allocator, _buffer, _capacity);
+        }
+
+        void take(dynamic_memory_output_stream& other) noexcept
+        {
+            _buffer = stdext::exchange(other._buffer, nullptr);
+            _capacity = stdext::exchange(other._capacity, 0);
+            _size = stdext::exchange(other._size, 0);
+            _position = stdext::exchange(other._position, 0);
+        }
+
+    private:
+        Allocator _allocator;
+        byte* _buffer = nullptr;
+        size_t _capacity = 0;
+        size_t _size = 0;
+        size_t _position = 0;
+    };
+
     class substream : public input_stream
     {
     public:
@@ -752,6 +1051,243 @@ namespace stdext
         input_stream* _stream = nullptr;
         size_t _max_extent = 0;
     };
+
+    // Reads from an underlying stream in blocks of buffer_size bytes, satisfying small reads
+    // from the buffer.  Reads at least as large as the buffer bypass it entirely.
+    class buffered_input_stream : public input_stream, public peekable, public direct_readable
+    {
+    public:
+        static constexpr size_t default_buffer_size = 0x1000;
+
+    public:
+        buffered_input_stream() = default;
+        buffered_input_stream(const buffered_input_stream&) = delete;
+        buffered_input_stream& operator = (const buffered_input_stream&) = delete;
+
+        buffered_input_stream(buffered_input_stream&& other) noexcept
+            : _stream(stdext::exchange(other._stream, nullptr)),
+            _buffer(stdext::move(other._buffer)),
+            _capacity(stdext::exchange(other._capacity, 0)),
+            _first(stdext::exchange(other._first, 0)),
+            _last(stdext::exchange(other._last, 0))
+        {
+        }
+
+        buffered_input_stream& operator = (buffered_input_stream&& other) noexcept
+        {
+            _stream = stdext::exchange(other._stream, nullptr);
+            _buffer = stdext::move(other._buffer);
+            _capacity = stdext::exchange(other._capacity, 0);
+            _first = stdext::exchange(other._first, 0);
+            _last = stdext::exchange(other._last, 0);
+            return *this;
+        }
+
+        explicit buffered_input_stream(input_stream& stream, size_t buffer_size = default_buffer_size)
+            : _stream(&stream), _buffer(std::make_unique<byte[]>(buffer_size)), _capacity(buffer_size)
+        {
+            assert(buffer_size != 0);
+        }
+
+        ~buffered_input_stream() override;
+
+    public:
+        bool is_attached() const noexcept { return _stream != nullptr; }
+
+        // Any data remaining in the buffer is discarded.
+        void attach(input_stream& stream, size_t buffer_size = default_buffer_size);
+
+        void detach() noexcept
+        {
+            _stream = nullptr;
+            _first = _last = 0;
+        }
+
+        size_t buffer_size() const noexcept { return _capacity; }
+        size_t buffered_size() const noexcept { return _last - _first; }
+
+        [[nodiscard]] size_t direct_read(std::function<size_t (const byte* buffer, size_t size)> read) final;
+
+    private:
+        [[nodiscard]] size_t do_read(byte* buffer, size_t size) final;
+        [[nodiscard]] size_t do_skip(size_t size) final;
+        [[nodiscard]] size_t do_peek(byte* buffer, size_t size) final;
+
+        size_t fill();
+
+    private:
+        input_stream* _stream = nullptr;
+        std::unique_ptr<byte[]> _buffer;
+        size_t _capacity = 0;
+        size_t _first = 0;
+        size_t _last = 0;
+    };
+
+    // Collects writes in a buffer of buffer_size bytes, passing them on to the underlying stream
+    // when the buffer fills up or when flush is called.  Writes at least as large as the buffer
+    // bypass it entirely.  The destructor flushes the buffer but has no way to report failure;
+    // call flush explicitly to observe errors.
+    class buffered_output_stream : public output_stream, public direct_writable
+    {
+    public:
+        static constexpr size_t default_buffer_size = 0x1000;
+
+    public:
+        buffered_output_stream() = default;
+        buffered_output_stream(const buffered_output_stream&) = delete;
+        buffered_output_stream& operator = (const buffered_output_stream&) = delete;
+
+        buffered_output_stream(buffered_output_stream&& other) noexcept
+            : _stream(stdext::exchange(other._stream, nullptr)),
+            _buffer(stdext::move(other._buffer)),
+            _capacity(stdext::exchange(other._capacity, 0)),
+            _last(stdext::exchange(other._last, 0))
+        {
+        }
+
+        buffered_output_stream& operator = (buffered_output_stream&& other);
+
+        explicit buffered_output_stream(output_stream& stream, size_t buffer_size = default_buffer_size)
+            : _stream(&stream), _buffer(std::make_unique<byte[]>(buffer_size)), _capacity(buffer_size)
+        {
+            assert(buffer_size != 0);
+        }
+
+        ~buffered_output_stream() override;
+
+    public:
+        bool is_attached() const noexcept { return _stream != nullptr; }
+
+        // Both attach and detach flush any data remaining in the buffer to the current stream.
+        void attach(output_stream& stream, size_t buffer_size = default_buffer_size);
+        void detach();
+
+        size_t buffer_size() const noexcept { return _capacity; }
+        size_t buffered_size() const noexcept { return _last; }
+
+        void flush();
+
+        [[nodiscard]] size_t direct_write(std::function<size_t (byte* buffer, size_t size)> write) final;
+
+    private:
+        [[nodiscard]] size_t do_write(const byte* buffer, size_t size) final;
+
+    private:
+        output_stream* _stream = nullptr;
+        std::unique_ptr<byte[]> _buffer;
+        size_t _capacity = 0;
+        size_t _last = 0;
+    };
+
+    // Hands out fixed-size memory segments for segmented_memory_stream, keeping released
+    // segments for reuse.  A pool may be shared by any number of streams on a single thread, and
+    // must outlive them.
+    class memory_segment_pool
+    {
+    public:
+        static constexpr size_t default_segment_size = 0x1000;
+
+    public:
+        explicit memory_segment_pool(size_t segment_size = default_segment_size) noexcept
+            : _segment_size(segment_size)
+        {
+            assert(segment_size != 0);
+        }
+
+        memory_segment_pool(const memory_segment_pool&) = delete;
+        memory_segment_pool& operator = (const memory_segment_pool&) = delete;
+        ~memory_segment_pool();
+
+    public:
+        size_t segment_size() const noexcept { return _segment_size; }
+
+        // Frees the segments that are not currently in use.
+        void trim() noexcept;
+
+    private:
+        friend class segmented_memory_stream;
+
+        struct segment
+        {
+            segment* next;
+
+            byte* data() noexcept { return reinterpret_cast<byte*>(this + 1); }
+        };
+
+        segment* allocate();
+        void release(segment* s) noexcept;
+
+    private:
+        size_t _segment_size;
+        segment* _free = nullptr;
+        size_t _outstanding = 0;
+    };
+
+    // A first-in, first-out stream that stores its contents as a chain of segments taken from a
+    // memory_segment_pool.  Writes append to the last segment and never move existing data;
+    // reads consume from the first, returning segments to the pool as they are emptied.
+    // direct_read and direct_write operate on one segment at a time, so repeated calls walk the
+    // chain without flattening it.
+    class segmented_memory_stream : public stream, public direct_readable, public direct_writable
+    {
+    public:
+        segmented_memory_stream() = default;
+        segmented_memory_stream(const segmented_memory_stream&) = delete;
+        segmented_memory_stream& operator = (const segmented_memory_stream&) = delete;
+
+        segmented_memory_stream(segmented_memory_stream&& other) noexcept
+            : _pool(stdext::exchange(other._pool, nullptr)),
+            _head(stdext::exchange(other._head, nullptr)),
+            _tail(stdext::exchange(other._tail, nullptr)),
+            _read_offset(stdext::exchange(other._read_offset, 0)),
+            _write_offset(stdext::exchange(other._write_offset, 0)),
+            _size(stdext::exchange(other._size, 0))
+        {
+        }
+
+        segmented_memory_stream& operator = (segmented_memory_stream&& other) noexcept;
+
+        explicit segmented_memory_stream(memory_segment_pool& pool) noexcept
+            : _pool(&pool)
+        {
+        }
+
+        ~segmented_memory_stream() override;
+
+    public:
+        // The number of bytes written but not yet read.
+        size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+
+        // Discards any unread data, returning all segments to the pool.
+        void clear() noexcept;
+
+        // Consumes as much unread data as stream accepts, passing the segments to it in a single
+        // vectored write where possible.  Returns the number of bytes written.
+        size_t write_to(output_stream& stream);
+
+        [[nodiscard]] size_t direct_read(std::function<size_t (const byte* buffer, size_t size)> read) final;
+        [[nodiscard]] size_t direct_write(std::function<size_t (byte* buffer, size_t size)> write) final;
+
+    private:
+        [[nodiscard]] size_t do_read(byte* buffer, size_t size) final;
+        [[nodiscard]] size_t do_skip(size_t size) final;
+        [[nodiscard]] size_t do_write(const byte* buffer, size_t size) final;
+
+        size_t readable_extent() const noexcept;
+        void consume(size_t size) noexcept;
+        void reserve_tail();
+
+    private:
+        using segment = memory_segment_pool::segment;
+
+        memory_segment_pool* _pool = nullptr;
+        segment* _head = nullptr;
+        segment* _tail = nullptr;
+        size_t _read_offset = 0;
+        size_t _write_offset = 0;
+        size_t _size = 0;
+    };
 }
 
 #endif
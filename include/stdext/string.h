@@ -55,6 +55,15 @@ namespace stdext
             return true;
         }
 
+        // Only an actual span picks this overload; anything else that converts to both a span and
+        // a string_view goes to the string_view overload.
+        template <typename Span, STDEXT_REQUIRES(std::is_same_v<Span, span<const charT>>)>
+        size_t operator () (Span values)
+        {
+            str.append(values.data(), values.size());
+            return values.size();
+        }
+
         string_type extract()
         {
             return stdext::exchange(str, { });
@@ -82,12 +91,87 @@ namespace stdext
             cstring_termination_predicate<iterator_value_type<std::decay_t<Iterator>>>);
     }
 
-    // Conversion between narrow and wide execution character sets
+    // Conversion between narrow and wide execution character sets.  When these are UTF-8 and
+    // UTF-16 or UTF-32, conversion is done directly, without consulting the C locale.
     std::string to_mbstring(const wchar_t* str);
     std::wstring to_wstring(const char* str);
 
     namespace _private
     {
+        constexpr bool utf8_narrow_charset = sizeof("\u00E9") == 3 && "\u00E9"[0] == '\xC3' && "\u00E9"[1] == '\xA9';
+        constexpr bool utf16_wide_charset = sizeof(L"\U0001F600") == 3 * sizeof(wchar_t) && L"\U0001F600"[0] == 0xD83D;
+        constexpr bool utf32_wide_charset = sizeof(L"\U0001F600") == 2 * sizeof(wchar_t) && L"\U0001F600"[0] == 0x1F600;
+        constexpr bool utf_execution_charsets = utf8_narrow_charset && (utf16_wide_charset || utf32_wide_charset);
+
+        // Stands in for std::mbstate_t when encoding UTF-8 directly; holds the leading half of a
+        // surrogate pair.
+        struct utf8_mbstate
+        {
+            char32_t lead = 0;
+
+            friend bool operator == (const utf8_mbstate& a, const utf8_mbstate& b) noexcept { return a.lead == b.lead; }
+            friend bool operator != (const utf8_mbstate& a, const utf8_mbstate& b) noexcept { return a.lead != b.lead; }
+        };
+
+        // Behaves like c16rtomb/c32rtomb in a UTF-8 locale.
+        template <typename Char>
+        size_t to_mb(char* s, Char c, utf8_mbstate* ps) noexcept
+        {
+            constexpr bool utf16 = sizeof(Char) == sizeof(char16_t)
+                || (std::is_same_v<Char, wchar_t> && utf16_wide_charset);
+
+            char32_t code = char32_t(std::make_unsigned_t<Char>(c));
+            if constexpr (utf16)
+            {
+                if (ps->lead != 0)
+                {
+                    if (code < 0xDC00 || code > 0xDFFF)
+                    {
+                        errno = EILSEQ;
+                        return size_t(-1);
+                    }
+
+                    code = 0x10000 + ((ps->lead & 0x03FF) << 10 | (code & 0x03FF));
+                    ps->lead = 0;
+                }
+                else if (code >= 0xD800 && code <= 0xDBFF)
+                {
+                    ps->lead = code;
+                    return 0;
+                }
+            }
+
+            if ((code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF)
+            {
+                errno = EILSEQ;
+                return size_t(-1);
+            }
+
+            if (code < 0x80)
+            {
+                s[0] = char(code);
+                return 1;
+            }
+            if (code < 0x800)
+            {
+                s[0] = char(0xC0 | code >> 6);
+                s[1] = char(0x80 | (code & 0x3F));
+                return 2;
+            }
+            if (code < 0x10000)
+            {
+                s[0] = char(0xE0 | code >> 12);
+                s[1] = char(0x80 | (code >> 6 & 0x3F));
+                s[2] = char(0x80 | (code & 0x3F));
+                return 3;
+            }
+            s[0] = char(0xF0 | code >> 18);
+            s[1] = char(0x80 | (code >> 12 & 0x3F));
+            s[2] = char(0x80 | (code >> 6 & 0x3F));
+            s[3] = char(0x80 | (code & 0x3F));
+            return 4;
+        }
+
 #if STDEXT_HAS_C_UNICODE
         inline size_t to_mb(char* s, char16_t c16, std::mbstate_t* ps)
         {
@@ -161,25 +245,39 @@ namespace stdext
     private:
         void next()
         {
-            if (_current == std::size(_value))
+            if (_current != std::size(_value) && ++_current != std::size(_value))
+                return;
+
+            // A leading surrogate produces no output by itself, so it must be followed by more
+            // input.
+            size_t length = 0;
+            bool consumed = false;
+            while (length == 0 && _g)
             {
-                assert(bool(_g));
-                auto length = _private::to_mb(_value, *_g, &_state);
+                length = _private::to_mb(_value, *_g, &_state);
                 ++_g;
                 if (length == size_t(-1))
                     throw std::system_error(errno, std::generic_category());
+                consumed = true;
+            }
 
-                _current = std::size(_value) - length;
-                std::move_backward(_value, _value + length, _value + std::size(_value));
+            if (length == 0)
+            {
+                if (consumed)
+                    throw std::system_error(EILSEQ, std::generic_category());
                 return;
             }
 
-            ++_current;
+            _current = std::size(_value) - length;
+            std::move_backward(_value, _value + length, _value + std::size(_value));
         }
 
+    private:
+        using state_type = std::conditional_t<_private::utf_execution_charsets, _private::utf8_mbstate, std::mbstate_t>;
+
     private:
         generator _g = { };
-        std::mbstate_t _state = { };
+        state_type _state = { };
         size_t _current = std::size(_value);
         value_type _value[MB_LEN_MAX] = { };
     };
@@ -14,7 +14,9 @@
 #include <stdext/array_view.h>
 
 #include <algorithm>
+#include <limits>
 #include <string>
+#include <system_error>
 
 
 // This string_view is similar to the proposed string_view in Library Fundamentals, but has
@@ -46,6 +48,45 @@ namespace stdext
     double stod(string_view str, size_t* idx = nullptr);
     long double stold(string_view str, size_t* idx = nullptr);
 
+    // Case mapping for the ASCII letters only; every other byte, including each byte of a
+    // multibyte UTF-8 sequence, is left alone.  The overloads taking out write str.size()
+    // characters there; out may be str.data() to map in place, but must not otherwise overlap.
+    void ascii_to_lower(string_view str, char* out) noexcept;
+    void ascii_to_upper(string_view str, char* out) noexcept;
+    std::string ascii_to_lower(string_view str);
+    std::string ascii_to_upper(string_view str);
+    bool ascii_equal_ignore_case(string_view a, string_view b) noexcept;
+
+    // Parses a number at the start of str in the manner of std::from_chars: no leading
+    // whitespace, plus sign, or radix prefix, and the C locale's notation whatever the current
+    // locale.  pos is the number of characters consumed.  If str doesn't start with a number, ec
+    // is std::errc::invalid_argument and pos is zero; if the number doesn't fit in T, ec is
+    // std::errc::result_out_of_range.  value is zero on error, except that a floating-point
+    // overflow produces infinity.  A floating-point value too small to represent isn't an error:
+    // it rounds to a subnormal value or to zero, keeping its sign.
+    template <typename T>
+    struct from_chars_result
+    {
+        T value;
+        size_t pos;
+        std::errc ec;
+    };
+
+    template <typename T, STDEXT_REQUIRES(std::is_integral_v<T> && !std::is_same_v<T, bool>)>
+    from_chars_result<T> from_chars(string_view str, int base = 10) noexcept;
+    // Accepts decimal fixed or scientific notation, inf, infinity, nan, and nan(chars), all
+    // optionally preceded by a minus sign.  Results are correctly rounded.
+    template <typename T, STDEXT_REQUIRES(std::is_floating_point_v<T>)>
+    from_chars_result<T> from_chars(string_view str) noexcept;
+
+    namespace _private
+    {
+        from_chars_result<uint64_t> parse_unsigned(const char* first, const char* last, int base) noexcept;
+        from_chars_result<float> parse_float(const char* first, const char* last) noexcept;
+        from_chars_result<double> parse_double(const char* first, const char* last) noexcept;
+        from_chars_result<long double> parse_long_double(const char* first, const char* last) noexcept;
+    }
+
     template <typename charT, typename traits>
     class basic_string_view : public array_view<const charT>
     {
@@ -258,6 +299,41 @@ namespace stdext
             return basic_string_view(*this, pos, n1).compare(basic_string_view(s, n2));
         }
     };
+
+    template <typename T, STDEXT_REQUIRED(std::is_integral_v<T> && !std::is_same_v<T, bool>)>
+    from_chars_result<T> from_chars(string_view str, int base) noexcept
+    {
+        static_assert(sizeof(T) <= sizeof(uint64_t));
+        using unsigned_type = std::make_unsigned_t<T>;
+
+        auto first = str.data();
+        auto last = first + str.size();
+        bool negative = std::is_signed_v<T> && first != last && *first == '-';
+        auto result = _private::parse_unsigned(first + negative, last, base);
+        if (result.ec == std::errc::invalid_argument)
+            return { T(), 0, result.ec };
+
+        result.pos += negative;
+        uint64_t limit = uint64_t(std::numeric_limits<T>::max()) + negative;
+        if (result.ec != std::errc() || result.value > limit)
+            return { T(), result.pos, std::errc::result_out_of_range };
+
+        auto value = unsigned_type(result.value);
+        return { T(negative ? unsigned_type(0 - value) : value), result.pos, std::errc() };
+    }
+
+    template <typename T, STDEXT_REQUIRED(std::is_floating_point_v<T>)>
+    from_chars_result<T> from_chars(string_view str) noexcept
+    {
+        auto first = str.data();
+        auto last = first + str.size();
+        if constexpr (std::is_same_v<T, float>)
+            return _private::parse_float(first, last);
+        else if constexpr (std::is_same_v<T, double>)
+            return _private::parse_double(first, last);
+        else
+            return _private::parse_long_double(first, last);
+    }
 }
 
 #endif
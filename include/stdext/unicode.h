@@ -12,8 +12,10 @@
 
 #include <stdext/flags.h>
 #include <stdext/range.h>
+#include <stdext/span.h>
 #include <stdext/string.h>
 
+#include <algorithm>
 #include <string>
 #include <tuple>
 
@@ -133,6 +135,56 @@ namespace stdext
     std::pair<utf_result, char32_t> to_utf32(char16_t in, utfstate_t& state);
     std::pair<utf_result, char32_t> to_utf32(char32_t in, utfstate_t& state);
 
+    struct utf_conversion_result
+    {
+        utf_result result;
+        size_t read;        // The number of input code units consumed.
+        size_t written;     // The number of output code units produced.
+    };
+
+    // Converts a contiguous block of code units, producing the same output and the same errors as
+    // feeding the block through the code unit functions above one unit at a time, but much faster.
+    // Conversion stops when the input is exhausted (utf_result::ok, or utf_result::partial_read
+    // if the input ends partway through a sequence, which is then held in state), when the output
+    // is full (utf_result::partial_write; read indicates where to resume), or, unless sanitizing,
+    // at an invalid sequence (utf_result::error; read is the offset of the offending code unit).
+    // Output is only ever produced for complete code points, so state carries partial input
+    // sequences from one call to the next, but never partial output.
+    utf_conversion_result to_utf8(span<const char> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf8(span<const char16_t> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf8(span<const char32_t> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf16(span<const char> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf16(span<const char16_t> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf16(span<const char32_t> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf32(span<const char> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf32(span<const char16_t> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+    utf_conversion_result to_utf32(span<const char32_t> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none);
+
+    // Equivalent to the generic to_u8string below, but measures the output exactly before
+    // encoding directly into the result.
+    std::pair<utf_result, std::string> to_u8string(span<const char16_t> in, flags<utf_conversion_options> options = utf_conversion_options::none);
+    std::pair<utf_result, std::string> to_u8string(span<const char32_t> in, flags<utf_conversion_options> options = utf_conversion_options::none);
+
+    // Checks that in is valid UTF-8 as accepted by to_utf32(char, utfstate_t&), without decoding
+    // it.  Returns the offset of the first sequence that would be rejected (including one cut off
+    // by the end of the input), or in.size() if the input is valid.
+    size_t utf8_validate(span<const char> in) noexcept;
+
+    // Measure text that is already known to be valid, without decoding it.  The results are
+    // meaningless for invalid input.
+    size_t utf8_count_code_points(span<const char> in) noexcept;
+    size_t utf16_length_from_utf8(span<const char> in) noexcept;
+    size_t utf8_length_from_utf16(span<const char16_t> in) noexcept;
+
+    // Simple case folding, per the C and S entries in the Unicode Character Database's
+    // CaseFolding.txt: each code point folds to exactly one code point, so strings that differ
+    // only in case fold to the same string.  Code points without a folding map to themselves.
+    // The string overloads replace invalid sequences with U+FFFD, as when sanitizing.
+    char32_t case_fold(char32_t code) noexcept;
+    std::string case_fold(span<const char> in);
+    std::u16string case_fold(span<const char16_t> in);
+    std::u32string case_fold(span<const char32_t> in);
+
     namespace _private
     {
         template <typename Char> struct utf_sentinel;
@@ -253,15 +305,83 @@ namespace stdext
             return result;
         }
 
+        // Strings, vectors, and the like, which can be handed to the bulk conversion functions.
+        // Arrays are excluded so that their handling is unchanged.
+        template <typename Producer, typename Char>
+        constexpr bool is_contiguous_input_v = !std::is_array_v<std::remove_reference_t<Producer>>
+            && std::is_constructible_v<span<const Char>, Producer&>;
+
         template <typename Char, typename Generator>
         std::pair<utf_result, std::basic_string<Char>> to_ustring(Generator&& in, flags<utf_conversion_options> options)
         {
             std::basic_string<Char> str;
             utfstate_t state;
-            return { to_utf<Char>(stdext::forward<Generator>(in), make_consumer<Char>(std::back_inserter(str)), state, options), stdext::move(str) };
+            return { to_utf<Char>(as_generator(stdext::forward<Generator>(in)), make_consumer<Char>(std::back_inserter(str)), state, options), stdext::move(str) };
         }
     }
 
+    // Converts text in chunks of any size, such as successive reads from a stream, carrying
+    // sequences that straddle chunk boundaries from one call to the next.
+    template <typename InChar, typename OutChar>
+    class utf_transcoder
+    {
+        static_assert(is_unicode_character_type_v<InChar> && is_unicode_character_type_v<OutChar>);
+
+    public:
+        utf_transcoder() noexcept = default;
+        explicit utf_transcoder(flags<utf_conversion_options> options) noexcept : _options(options) { }
+
+    public:
+        // Converts as much of in as fits in out, as the span conversion functions do.  A
+        // utf_result::partial_read result only means that the chunk ended partway through a
+        // sequence; pass the next chunk to continue.
+        utf_conversion_result convert(span<const InChar> in, span<OutChar> out)
+        {
+            if constexpr (std::is_same_v<OutChar, char>)
+                return to_utf8(in, out, _state, _options);
+            else if constexpr (std::is_same_v<OutChar, char16_t>)
+                return to_utf16(in, out, _state, _options);
+            else
+                return to_utf32(in, out, _state, _options);
+        }
+
+        // Call once the input is exhausted.  A sequence left incomplete by the last chunk is
+        // replaced with U+FFFD when sanitizing, and is an error otherwise.
+        utf_conversion_result finish(span<OutChar> out)
+        {
+            if (_state.consumed == 0)
+                return { utf_result::ok, 0, 0 };
+            if (!_options.test_any(utf_conversion_options::sanitize))
+                return { utf_result::error, 0, 0 };
+
+            OutChar units[4];
+            size_t count = 0;
+            utfstate_t state;
+            utf_result result;
+            do
+                std::tie(result, units[count++]) = _private::to_utf<OutChar>(UNICODE_REPLACEMENT_CHARACTER, state);
+            while (result == utf_result::partial_write);
+
+            if (out.size() < count)
+                return { utf_result::partial_write, 0, 0 };
+
+            std::copy_n(units, count, out.data());
+            _state = { };
+            return { utf_result::ok, 0, count };
+        }
+
+        // True if the last chunk ended partway through a sequence.
+        bool pending() const noexcept { return _state.consumed != 0; }
+
+        void reset() noexcept { _state = { }; }
+
+        flags<utf_conversion_options> options() const noexcept { return _options; }
+
+    private:
+        utfstate_t _state;
+        flags<utf_conversion_options> _options = utf_conversion_options::none;
+    };
+
     template <typename Producer, typename Consumer,
         STDEXT_REQUIRES(is_consumer_v<std::decay_t<Consumer>, generator_value_type<generator_type<Producer>>>)>
     utf_result to_utf8(Producer&& in, Consumer&& out, utfstate_t& state, flags<utf_conversion_options> options = utf_conversion_options::none)
@@ -346,7 +466,12 @@ namespace stdext
     template <typename Producer, STDEXT_REQUIRES(can_generate_v<Producer>)>
     std::pair<utf_result, std::string> to_u8string(Producer&& in, flags<utf_conversion_options> options = utf_conversion_options::none)
     {
-        return _private::to_ustring<char>(stdext::forward<Producer>(in), options);
+        if constexpr (_private::is_contiguous_input_v<Producer, char16_t>)
+            return to_u8string(span<const char16_t>(in), options);
+        else if constexpr (_private::is_contiguous_input_v<Producer, char32_t>)
+            return to_u8string(span<const char32_t>(in), options);
+        else
+            return _private::to_ustring<char>(stdext::forward<Producer>(in), options);
     }
 
     template <typename Char, STDEXT_REQUIRES(is_unicode_character_type_v<std::decay_t<Char>>)>
@@ -0,0 +1,146 @@
+//
+//  utf8_indexed_string.h
+//  stdext
+//
+//  Created by James Touton on 10/17/26.
+//  Copyright © 2026 James Touton. All rights reserved.
+//
+
+#ifndef STDEXT_UTF8_INDEXED_STRING_INCLUDED
+#define STDEXT_UTF8_INDEXED_STRING_INCLUDED
+#pragma once
+
+#include <stdext/string_view.h>
+#include <stdext/unicode.h>
+
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+namespace stdext
+{
+    // A UTF-8 string that can be addressed by code point.  Alongside the text, it keeps the byte
+    // offset of every index_interval-th code point, so finding the nth code point (or the code
+    // point at a given byte offset) touches at most index_interval code points rather than
+    // scanning from the start.  The contents are always valid UTF-8; invalid input is sanitized
+    // on construction, as by utf_conversion_options::sanitize.
+    class utf8_indexed_string
+    {
+    public:
+        static constexpr size_t index_interval = 64;
+        static constexpr size_t npos = size_t(-1);
+
+        // Iterates over code points.  Bidirectional, so reverse iteration is available through
+        // rbegin and rend.
+        class const_iterator
+        {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = char32_t;
+            using difference_type = ptrdiff_t;
+            using pointer = void;
+            using reference = char32_t;
+
+        public:
+            const_iterator() noexcept = default;
+
+        public:
+            char32_t operator * () const noexcept
+            {
+                auto length = utf8_character_length(*_p);
+                char32_t code = uint8_t(*_p) & (length == 1 ? 0x7F : 0xFF >> (length + 1));
+                for (size_t n = 1; n < length; ++n)
+                    code = code << 6 | (uint8_t(_p[n]) & 0x3F);
+                return code;
+            }
+
+            const_iterator& operator ++ () noexcept
+            {
+                _p += utf8_character_length(*_p);
+                return *this;
+            }
+
+            const_iterator operator ++ (int) noexcept
+            {
+                auto i = *this;
+                ++*this;
+                return i;
+            }
+
+            const_iterator& operator -- () noexcept
+            {
+                while (utf8_is_trailing(*--_p))
+                    ;
+                return *this;
+            }
+
+            const_iterator operator -- (int) noexcept
+            {
+                auto i = *this;
+                --*this;
+                return i;
+            }
+
+            friend bool operator == (const const_iterator& a, const const_iterator& b) noexcept { return a._p == b._p; }
+            friend bool operator != (const const_iterator& a, const const_iterator& b) noexcept { return a._p != b._p; }
+
+            // The position of the code point within the underlying string.
+            const char* base() const noexcept { return _p; }
+
+        private:
+            friend class utf8_indexed_string;
+            explicit const_iterator(const char* p) noexcept : _p(p) { }
+
+        private:
+            const char* _p = nullptr;
+        };
+
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    public:
+        utf8_indexed_string() = default;
+        explicit utf8_indexed_string(std::string str);
+        explicit utf8_indexed_string(string_view str);
+
+    public:
+        void assign(std::string str);
+
+        const std::string& str() const noexcept { return _str; }
+        const char* data() const noexcept { return _str.data(); }
+        size_t size_bytes() const noexcept { return _str.size(); }
+
+        // The number of code points.
+        size_t size() const noexcept { return _size; }
+        bool empty() const noexcept { return _size == 0; }
+
+        const_iterator begin() const noexcept { return const_iterator(_str.data()); }
+        const_iterator end() const noexcept { return const_iterator(_str.data() + _str.size()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+        // An iterator to the nth code point, or end() if n == size().
+        const_iterator nth(size_t n) const noexcept;
+        char32_t nth_code_point(size_t n) const noexcept { assert(n < _size); return *nth(n); }
+
+        // The byte offset of the nth code point, or size_bytes() if n == size().
+        size_t offset_of(size_t n) const noexcept { return size_t(nth(n).base() - _str.data()); }
+        // The number of the code point containing the byte at offset, which need not be the
+        // first byte of the code point.  Returns size() if offset == size_bytes().
+        size_t code_point_at(size_t offset) const noexcept;
+
+        // The code points in [pos, pos + count), clamped to the end of the string.
+        string_view substr(size_t pos, size_t count = npos) const noexcept;
+
+    private:
+        void build_index();
+
+    private:
+        std::string _str;
+        std::vector<size_t> _index;     // _index[k] is the byte offset of code point k * index_interval.
+        size_t _size = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,168 @@
+//
+//  utf_stream.h
+//  stdext
+//
+//  Created by James Touton on 10/17/26.
+//  Copyright © 2026 James Touton. All rights reserved.
+//
+
+#ifndef STDEXT_UTF_STREAM_INCLUDED
+#define STDEXT_UTF_STREAM_INCLUDED
+#pragma once
+
+#include <stdext/stream.h>
+#include <stdext/unicode.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+
+namespace stdext
+{
+    // Converts text written as InChar code units to OutChar code units, passing the result on
+    // to the underlying stream a buffer at a time.  Code units (and code points) may be split
+    // across writes arbitrarily, so a file can be re-encoded in constant memory by copying it
+    // through in blocks of any size.  Both encodings use native byte order.  Invalid input
+    // throws stream_error unless sanitizing.  Call finish at the end of the input; the
+    // destructor flushes the buffer but, like buffered_output_stream, can't report failure.
+    template <typename InChar, typename OutChar>
+    class utf_transcoding_output_stream : public output_stream
+    {
+    public:
+        static constexpr size_t default_buffer_size = 0x1000;   // In OutChar code units.
+
+    public:
+        utf_transcoding_output_stream(const utf_transcoding_output_stream&) = delete;
+        utf_transcoding_output_stream& operator = (const utf_transcoding_output_stream&) = delete;
+
+        explicit utf_transcoding_output_stream(output_stream& stream, flags<utf_conversion_options> options = utf_conversion_options::none, size_t buffer_size = default_buffer_size)
+            : _stream(&stream), _transcoder(options), _buffer(std::make_unique<OutChar[]>(buffer_size)), _capacity(buffer_size)
+        {
+            // Room for at least one complete code point.
+            assert(buffer_size >= 4);
+        }
+
+        ~utf_transcoding_output_stream() override
+        {
+            try
+            {
+                flush();
+            }
+            catch (...)
+            {
+            }
+        }
+
+    public:
+        // Passes converted text on to the underlying stream.  A sequence split across writes
+        // remains pending.
+        void flush()
+        {
+            _stream->write_all(_buffer.get(), _last);
+            _last = 0;
+        }
+
+        // Ends the input, resolving any sequence left incomplete as utf_transcoder::finish
+        // does, and flushes.
+        void finish()
+        {
+            if (_partial_size != 0)
+            {
+                if (!_transcoder.options().test_any(utf_conversion_options::sanitize))
+                    throw stream_error("invalid UTF sequence");
+                _partial_size = 0;
+                convert(span<const InChar>(&invalid_unit, 1));
+            }
+
+            if (_capacity - _last < 4)
+                flush();
+
+            auto result = _transcoder.finish(span<OutChar>(_buffer.get() + _last, _capacity - _last));
+            if (result.result == utf_result::error)
+                throw stream_error("invalid UTF sequence");
+
+            _last += result.written;
+            flush();
+        }
+
+    private:
+        // Stands in for a code unit cut short by the end of the input, so that it is replaced
+        // like any other invalid code unit.
+        static constexpr InChar invalid_unit = InChar(sizeof(InChar) == 1 ? 0xFF : 0xFFFF);
+
+        [[nodiscard]] size_t do_write(const byte* buffer, size_t size) final
+        {
+            auto first = buffer;
+            auto last = buffer + size;
+
+            // Complete a code unit split by the previous write.
+            if (_partial_size != 0)
+            {
+                auto count = std::min(sizeof(InChar) - _partial_size, size);
+                std::memcpy(_partial + _partial_size, first, count);
+                _partial_size += count;
+                first += count;
+                if (_partial_size != sizeof(InChar))
+                    return size;
+
+                InChar unit;
+                std::memcpy(&unit, _partial, sizeof(InChar));
+                _partial_size = 0;
+                convert(span<const InChar>(&unit, 1));
+            }
+
+            if constexpr (sizeof(InChar) == 1)
+            {
+                convert(span<const InChar>(reinterpret_cast<const InChar*>(first), size_t(last - first)));
+                return size;
+            }
+            else
+            {
+                // The input may not be suitably aligned, so wider code units are staged.
+                constexpr size_t staging_size = 0x100;
+                InChar staging[staging_size];
+                while (size_t(last - first) >= sizeof(InChar))
+                {
+                    auto count = std::min(size_t(last - first) / sizeof(InChar), staging_size);
+                    std::memcpy(staging, first, count * sizeof(InChar));
+                    convert(span<const InChar>(staging, count));
+                    first += count * sizeof(InChar);
+                }
+
+                _partial_size = size_t(last - first);
+                std::memcpy(_partial, first, _partial_size);
+                return size;
+            }
+        }
+
+        void convert(span<const InChar> in)
+        {
+            for (;;)
+            {
+                auto result = _transcoder.convert(in, span<OutChar>(_buffer.get() + _last, _capacity - _last));
+                _last += result.written;
+                in = in.subspan(result.read);
+
+                if (result.result == utf_result::error)
+                    throw stream_error("invalid UTF sequence");
+                if (result.result != utf_result::partial_write)
+                    return;
+
+                flush();
+            }
+        }
+
+    private:
+        output_stream* _stream;
+        utf_transcoder<InChar, OutChar> _transcoder;
+        std::unique_ptr<OutChar[]> _buffer;
+        size_t _capacity;
+        size_t _last = 0;
+        byte _partial[sizeof(InChar)];
+        size_t _partial_size = 0;
+    };
+}
+
+#endif
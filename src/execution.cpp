@@ -0,0 +1,274 @@
+#include <stdext/execution.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        namespace
+        {
+            class work_queue
+            {
+            public:
+                void push(parallel_task& task)
+                {
+                    std::lock_guard lock(_mutex);
+                    _tasks.push_back(&task);
+                }
+
+                // Takes task back if nobody has stolen it yet.  Anything forked after task has
+                // already been joined, so task can only be at the back.
+                bool pop(parallel_task& task) noexcept
+                {
+                    std::lock_guard lock(_mutex);
+                    if (_tasks.empty() || _tasks.back() != &task)
+                        return false;
+
+                    _tasks.pop_back();
+                    return true;
+                }
+
+                parallel_task* steal() noexcept
+                {
+                    std::lock_guard lock(_mutex);
+                    if (_tasks.empty())
+                        return nullptr;
+
+                    auto task = _tasks.front();
+                    _tasks.pop_front();
+                    return task;
+                }
+
+            private:
+                std::mutex _mutex;
+                std::deque<parallel_task*> _tasks;
+            };
+
+            // Set by scoped_thread_pool.
+            std::atomic<thread_pool*> scoped_pool = nullptr;
+        }
+
+        class thread_pool
+        {
+        public:
+            explicit thread_pool(unsigned thread_count) : _queues(thread_count)
+            {
+                for (auto& queue : _queues)
+                    queue = std::make_unique<work_queue>();
+
+                // A pool that can't start all of its threads just runs with fewer.
+                _threads.reserve(thread_count);
+                try
+                {
+                    for (unsigned index = 0; index != thread_count; ++index)
+                        _threads.emplace_back([this, index] { run(index); });
+                }
+                catch (const std::system_error&)
+                {
+                }
+            }
+
+            ~thread_pool()
+            {
+                {
+                    std::lock_guard lock(_mutex);
+                    _stopping = true;
+                }
+                _work_ready.notify_all();
+
+                for (auto& thread : _threads)
+                    thread.join();
+            }
+
+        public:
+            static thread_pool& instance()
+            {
+                if (auto pool = scoped_pool.load(std::memory_order_acquire))
+                    return *pool;
+
+                // With a single hardware thread, everything runs on the caller.
+                auto count = std::thread::hardware_concurrency();
+                static thread_pool pool(count > 1 ? count : 0);
+                return pool;
+            }
+
+            unsigned concurrency() const noexcept
+            {
+                return std::max(unsigned(_threads.size()), 1u);
+            }
+
+            void fork(parallel_task& task)
+            {
+                if (current_pool != this)
+                    return;
+
+                _queues[current_index]->push(task);
+                queued();
+            }
+
+            void join(parallel_task& task) noexcept
+            {
+                if (current_pool != this)
+                {
+                    task.run();
+                    return;
+                }
+
+                if (_queues[current_index]->pop(task))
+                {
+                    _pending.fetch_sub(1);
+                    task.run();
+                    return;
+                }
+
+                while (!task.done())
+                {
+                    if (!help(current_index))
+                        std::this_thread::yield();
+                }
+            }
+
+            void execute(parallel_task& task)
+            {
+                if (current_pool == this || _threads.empty())
+                {
+                    task.run();
+                    return;
+                }
+
+                {
+                    std::lock_guard lock(_mutex);
+                    _injected.push_back(&task);
+                }
+                queued();
+
+                std::unique_lock lock(_mutex);
+                _work_done.wait(lock, [&] { return task.done(); });
+            }
+
+        private:
+            void queued()
+            {
+                _pending.fetch_add(1);
+                if (_sleeping.load() != 0)
+                {
+                    // Taking the lock ensures that a thread about to sleep either sees the new
+                    // work or is already waiting for the notification.
+                    std::lock_guard lock(_mutex);
+                }
+                _work_ready.notify_one();
+            }
+
+            void run(unsigned index)
+            {
+                current_pool = this;
+                current_index = index;
+
+                for (;;)
+                {
+                    if (help(index))
+                        continue;
+
+                    std::unique_lock lock(_mutex);
+                    _sleeping.fetch_add(1);
+                    _work_ready.wait(lock, [this] { return _stopping || _pending.load() != 0; });
+                    _sleeping.fetch_sub(1);
+                    if (_stopping)
+                        return;
+                }
+            }
+
+            // Runs one task taken from elsewhere in the pool, if there is one.
+            bool help(unsigned index) noexcept
+            {
+                auto count = unsigned(_queues.size());
+                for (unsigned n = 1; n != count; ++n)
+                {
+                    if (auto task = _queues[(index + n) % count]->steal())
+                    {
+                        _pending.fetch_sub(1);
+                        task->run();
+                        return true;
+                    }
+                }
+
+                parallel_task* task = nullptr;
+                {
+                    std::lock_guard lock(_mutex);
+                    if (_injected.empty())
+                        return false;
+
+                    task = _injected.front();
+                    _injected.pop_front();
+                }
+
+                _pending.fetch_sub(1);
+                task->run();
+
+                // The caller may destroy task as soon as it sees that it's done, so the
+                // notification must not touch it.
+                {
+                    std::lock_guard lock(_mutex);
+                }
+                _work_done.notify_all();
+                return true;
+            }
+
+        private:
+            static thread_local thread_pool* current_pool;
+            static thread_local unsigned current_index;
+
+            std::vector<std::unique_ptr<work_queue>> _queues;
+            std::vector<std::thread> _threads;
+            std::deque<parallel_task*> _injected;
+            std::atomic<size_t> _pending = 0;
+            std::atomic<unsigned> _sleeping = 0;
+            std::mutex _mutex;
+            std::condition_variable _work_ready;
+            std::condition_variable _work_done;
+            bool _stopping = false;
+        };
+
+        thread_local thread_pool* thread_pool::current_pool = nullptr;
+        thread_local unsigned thread_pool::current_index = 0;
+
+        void parallel_fork(parallel_task& task)
+        {
+            thread_pool::instance().fork(task);
+        }
+
+        void parallel_join(parallel_task& task) noexcept
+        {
+            thread_pool::instance().join(task);
+        }
+
+        void parallel_execute(parallel_task& task)
+        {
+            thread_pool::instance().execute(task);
+        }
+
+        unsigned parallel_concurrency() noexcept
+        {
+            return thread_pool::instance().concurrency();
+        }
+
+        scoped_thread_pool::scoped_thread_pool(unsigned thread_count)
+            : _pool(std::make_unique<thread_pool>(thread_count)), _previous(scoped_pool.exchange(_pool.get()))
+        {
+        }
+
+        scoped_thread_pool::~scoped_thread_pool()
+        {
+            scoped_pool.store(_previous);
+        }
+    }
+}
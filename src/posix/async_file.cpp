@@ -0,0 +1,628 @@
+#include <stdext/async_file.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "open_flags.h"
+
+// The quoted form keeps the predefined macro 'linux' from being expanded within the path.
+#if STDEXT_PLATFORM_LINUX && STDEXT_HAS_INCLUDE("linux/io_uring.h") && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define STDEXT_HAS_IO_URING 1
+#else
+#define STDEXT_HAS_IO_URING 0
+#endif
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        struct async_request
+        {
+            async_request(bool write, stream_position position, byte* buffer, size_t size, async_completion completion)
+                : write(write), position(position), buffer(buffer), size(size), completion(stdext::move(completion))
+            {
+            }
+
+            bool write;
+            stream_position position;
+            byte* buffer;
+            size_t size;
+            async_completion completion;
+
+            std::error_code error;
+            size_t transferred = 0;
+            iovec vector = { };
+        };
+
+        class async_engine
+        {
+        public:
+            virtual ~async_engine() = default;
+
+        public:
+            virtual async_file_backend backend() const noexcept = 0;
+
+            void enqueue(std::unique_ptr<async_request> request)
+            {
+                _queued.push_back(stdext::move(request));
+                ++_pending;
+            }
+
+            size_t pending() const noexcept { return _pending; }
+
+            // Hands as many queued requests as possible to the backend.
+            virtual size_t submit() = 0;
+            // Runs callbacks for completed requests, blocking until at least count of them have
+            // run.  The caller must ensure that at least count requests have been submitted.
+            virtual size_t reap(size_t count) = 0;
+
+        protected:
+            void complete(std::unique_ptr<async_request> request)
+            {
+                --_pending;
+                request->completion(request->error, request->transferred);
+            }
+
+        protected:
+            std::deque<std::unique_ptr<async_request>> _queued;
+
+        private:
+            size_t _pending = 0;
+        };
+    }
+
+    namespace
+    {
+        using _private::async_request;
+        using _private::async_engine;
+
+        constexpr unsigned max_worker_threads = 32;
+        constexpr unsigned max_ring_entries = 4096;
+
+        std::unique_ptr<async_engine> make_engine(int fd, unsigned queue_depth, async_file_backend backend);
+
+        class thread_pool_engine final : public async_engine
+        {
+        public:
+            thread_pool_engine(int fd, unsigned thread_count) : _fd(fd)
+            {
+                _workers.reserve(thread_count);
+                try
+                {
+                    while (thread_count-- != 0)
+                        _workers.emplace_back([this] { run(); });
+                }
+                catch (...)
+                {
+                    stop();
+                    throw;
+                }
+            }
+
+            ~thread_pool_engine() override
+            {
+                stop();
+            }
+
+        public:
+            async_file_backend backend() const noexcept override { return async_file_backend::thread_pool; }
+
+            size_t submit() override
+            {
+                auto count = _queued.size();
+                if (count == 0)
+                    return 0;
+
+                {
+                    std::lock_guard lock(_mutex);
+                    std::move(_queued.begin(), _queued.end(), std::back_inserter(_work));
+                }
+                _queued.clear();
+                _work_ready.notify_all();
+                return count;
+            }
+
+            size_t reap(size_t count) override
+            {
+                size_t reaped = 0;
+                for (;;)
+                {
+                    std::unique_ptr<async_request> request;
+                    {
+                        std::unique_lock lock(_mutex);
+                        if (reaped < count)
+                            _work_done.wait(lock, [this] { return !_completed.empty(); });
+                        else if (_completed.empty())
+                            return reaped;
+
+                        request = stdext::move(_completed.front());
+                        _completed.pop_front();
+                    }
+
+                    ++reaped;
+                    complete(stdext::move(request));
+                }
+            }
+
+        private:
+            void run()
+            {
+                for (;;)
+                {
+                    std::unique_ptr<async_request> request;
+                    {
+                        std::unique_lock lock(_mutex);
+                        _work_ready.wait(lock, [this] { return _stopping || !_work.empty(); });
+                        if (_work.empty())
+                            return;
+
+                        request = stdext::move(_work.front());
+                        _work.pop_front();
+                    }
+
+                    perform(*request);
+
+                    {
+                        std::lock_guard lock(_mutex);
+                        _completed.push_back(stdext::move(request));
+                    }
+                    _work_done.notify_one();
+                }
+            }
+
+            void perform(async_request& request) noexcept
+            {
+                while (request.transferred != request.size)
+                {
+                    auto buffer = request.buffer + request.transferred;
+                    auto size = request.size - request.transferred;
+                    auto position = off_t(request.position + request.transferred);
+                    auto bytes = request.write
+                        ? ::pwrite(_fd, buffer, size, position)
+                        : ::pread(_fd, buffer, size, position);
+                    if (bytes == -1)
+                    {
+                        if (errno == EINTR)
+                            continue;
+
+                        request.error = { errno, std::generic_category() };
+                        return;
+                    }
+
+                    if (bytes == 0)
+                        return;
+
+                    request.transferred += bytes;
+                }
+            }
+
+            void stop() noexcept
+            {
+                {
+                    std::lock_guard lock(_mutex);
+                    _stopping = true;
+                }
+                _work_ready.notify_all();
+
+                for (auto& worker : _workers)
+                    worker.join();
+            }
+
+        private:
+            int _fd;
+            std::vector<std::thread> _workers;
+            std::mutex _mutex;
+            std::condition_variable _work_ready;
+            std::condition_variable _work_done;
+            std::deque<std::unique_ptr<async_request>> _work;
+            std::deque<std::unique_ptr<async_request>> _completed;
+            bool _stopping = false;
+        };
+
+#if STDEXT_HAS_IO_URING
+        // Talks to the kernel through the raw system calls, so no support library is needed.
+        class io_uring_engine final : public async_engine
+        {
+        public:
+            // Returns null if io_uring is unavailable (older kernels, or disabled by policy).
+            static std::unique_ptr<io_uring_engine> create(int fd, unsigned queue_depth)
+            {
+                io_uring_params params = { };
+                auto ring = int(::syscall(__NR_io_uring_setup, queue_depth, &params));
+                if (ring == -1)
+                    return nullptr;
+
+                std::unique_ptr<io_uring_engine> engine(new io_uring_engine(fd, ring));
+                if (!engine->map(params))
+                    return nullptr;
+
+                return engine;
+            }
+
+            ~io_uring_engine() override
+            {
+                // Requests still in flight must not outlive the ring; their callbacks are
+                // dropped.
+                try
+                {
+                    while (_in_flight != 0)
+                    {
+                        if (*_cq_head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+                            enter(0, 1, IORING_ENTER_GETEVENTS);
+                        else
+                            next_completion();
+                    }
+                }
+                catch (...)
+                {
+                }
+
+                if (_sqes != nullptr)
+                    ::munmap(_sqes, _sqes_size);
+                if (_cq_ring != nullptr && _cq_ring != _sq_ring)
+                    ::munmap(_cq_ring, _cq_ring_size);
+                if (_sq_ring != nullptr)
+                    ::munmap(_sq_ring, _sq_ring_size);
+                ::close(_ring);
+            }
+
+        public:
+            async_file_backend backend() const noexcept override { return async_file_backend::io_uring; }
+
+            size_t submit() override
+            {
+                size_t submitted = 0;
+                auto tail = *_sq_tail;
+                while (!_queued.empty() && _in_flight != _depth)
+                {
+                    auto request = stdext::move(_queued.front());
+                    _queued.pop_front();
+
+                    request->vector.iov_base = request->buffer + request->transferred;
+                    request->vector.iov_len = request->size - request->transferred;
+
+                    auto& sqe = _sqes[tail & _sq_mask];
+                    sqe = { };
+                    sqe.opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+                    sqe.fd = _fd;
+                    sqe.off = request->position + request->transferred;
+                    sqe.addr = reinterpret_cast<uintptr_t>(&request->vector);
+                    sqe.len = 1;
+                    sqe.user_data = reinterpret_cast<uintptr_t>(request.release());
+
+                    ++tail;
+                    ++_in_flight;
+                    ++submitted;
+                }
+
+                if (submitted != 0)
+                {
+                    __atomic_store_n(_sq_tail, tail, __ATOMIC_RELEASE);
+                    enter(unsubmitted(), 0, 0);
+                }
+
+                return submitted;
+            }
+
+            size_t reap(size_t count) override
+            {
+                size_t reaped = 0;
+                for (;;)
+                {
+                    if (*_cq_head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+                    {
+                        // Refill the slots freed by the completions seen so far.
+                        submit();
+                        if (reaped >= count || _in_flight == 0)
+                            return reaped;
+
+                        enter(unsubmitted(), 1, IORING_ENTER_GETEVENTS);
+                        continue;
+                    }
+
+                    auto request = next_completion();
+                    if (!request->error && request->transferred != request->size && request->vector.iov_len != 0)
+                    {
+                        // Short transfers are continued where they left off; only end of file
+                        // (a zero-length result) or an error completes a request early.
+                        _queued.push_front(stdext::move(request));
+                        continue;
+                    }
+
+                    ++reaped;
+                    complete(stdext::move(request));
+                }
+            }
+
+        private:
+            io_uring_engine(int fd, int ring) noexcept : _fd(fd), _ring(ring)
+            {
+            }
+
+            bool map(const io_uring_params& params) noexcept
+            {
+                _depth = params.sq_entries;
+                _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP)
+                    _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+
+                auto sq_ring = ::mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQ_RING);
+                if (sq_ring == MAP_FAILED)
+                    return false;
+                _sq_ring = static_cast<byte*>(sq_ring);
+
+                if (params.features & IORING_FEAT_SINGLE_MMAP)
+                    _cq_ring = _sq_ring;
+                else
+                {
+                    auto cq_ring = ::mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_CQ_RING);
+                    if (cq_ring == MAP_FAILED)
+                        return false;
+                    _cq_ring = static_cast<byte*>(cq_ring);
+                }
+
+                _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+                auto sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES);
+                if (sqes == MAP_FAILED)
+                    return false;
+                _sqes = static_cast<io_uring_sqe*>(sqes);
+
+                _sq_head = reinterpret_cast<unsigned*>(_sq_ring + params.sq_off.head);
+                _sq_tail = reinterpret_cast<unsigned*>(_sq_ring + params.sq_off.tail);
+                _sq_mask = *reinterpret_cast<unsigned*>(_sq_ring + params.sq_off.ring_mask);
+                _cq_head = reinterpret_cast<unsigned*>(_cq_ring + params.cq_off.head);
+                _cq_tail = reinterpret_cast<unsigned*>(_cq_ring + params.cq_off.tail);
+                _cq_mask = *reinterpret_cast<unsigned*>(_cq_ring + params.cq_off.ring_mask);
+                _cqes = reinterpret_cast<io_uring_cqe*>(_cq_ring + params.cq_off.cqes);
+
+                // Submission queue entries are always used in ring order.
+                auto array = reinterpret_cast<unsigned*>(_sq_ring + params.sq_off.array);
+                for (unsigned n = 0; n != params.sq_entries; ++n)
+                    array[n] = n;
+
+                return true;
+            }
+
+            unsigned unsubmitted() const noexcept
+            {
+                return *_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            }
+
+            void enter(unsigned to_submit, unsigned min_complete, unsigned flags)
+            {
+                while (::syscall(__NR_io_uring_enter, _ring, to_submit, min_complete, flags, nullptr, 0) == -1)
+                {
+                    if (errno != EINTR)
+                        throw std::system_error(errno, std::generic_category());
+                    to_submit = unsubmitted();
+                }
+            }
+
+            std::unique_ptr<async_request> next_completion() noexcept
+            {
+                auto head = *_cq_head;
+                auto& cqe = _cqes[head & _cq_mask];
+                std::unique_ptr<async_request> request(reinterpret_cast<async_request*>(cqe.user_data));
+                auto result = cqe.res;
+                __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+                --_in_flight;
+
+                if (result < 0)
+                    request->error = { -result, std::generic_category() };
+                else
+                {
+                    request->transferred += size_t(result);
+                    if (result == 0)
+                        request->vector.iov_len = 0;
+                }
+
+                return request;
+            }
+
+        private:
+            int _fd;
+            int _ring;
+            unsigned _depth = 0;
+            unsigned _in_flight = 0;
+
+            byte* _sq_ring = nullptr;
+            size_t _sq_ring_size = 0;
+            byte* _cq_ring = nullptr;
+            size_t _cq_ring_size = 0;
+            io_uring_sqe* _sqes = nullptr;
+            size_t _sqes_size = 0;
+
+            unsigned* _sq_head = nullptr;
+            unsigned* _sq_tail = nullptr;
+            unsigned _sq_mask = 0;
+            unsigned* _cq_head = nullptr;
+            unsigned* _cq_tail = nullptr;
+            unsigned _cq_mask = 0;
+            io_uring_cqe* _cqes = nullptr;
+        };
+#endif
+    }
+
+    async_file::async_file() noexcept : _handle(-1)
+    {
+    }
+
+    async_file::async_file(async_file&& other) noexcept
+        : _handle(stdext::exchange(other._handle, -1)), _engine(stdext::move(other._engine))
+    {
+    }
+
+    async_file& async_file::operator = (async_file&& other)
+    {
+        if (is_open())
+            close();
+
+        _handle = stdext::exchange(other._handle, -1);
+        _engine = stdext::move(other._engine);
+        return *this;
+    }
+
+    async_file::~async_file()
+    {
+        if (!is_open())
+            return;
+
+        try
+        {
+            wait_all();
+        }
+        catch (...)
+        {
+        }
+
+        _engine.reset();
+        ::close(_handle);
+    }
+
+    async_file::async_file(const path_char* path, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+        : async_file()
+    {
+        if (auto error = open(path, mode, flags, queue_depth, backend))
+            throw std::system_error(error);
+    }
+
+    async_file::async_file(const char* path, utf8_path_encoding, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+        : async_file(path, mode, flags, queue_depth, backend)
+    {
+    }
+
+    std::error_code async_file::open(const path_char* path, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+    {
+        assert(!is_open());
+        assert(queue_depth != 0);
+
+        auto access = mode == async_file_mode::read ? O_RDONLY : O_RDWR;
+        auto handle = ::open(path, access | _private::creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (handle == -1)
+            return { errno, std::generic_category() };
+
+        try
+        {
+            _engine = make_engine(handle, queue_depth, backend);
+        }
+        catch (...)
+        {
+            ::close(handle);
+            throw;
+        }
+
+        if (_engine == nullptr)
+        {
+            ::close(handle);
+            return make_error_code(std::errc::not_supported);
+        }
+
+        _handle = handle;
+        return { };
+    }
+
+    std::error_code async_file::open(const char* path, utf8_path_encoding, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+    {
+        return open(path, mode, flags, queue_depth, backend);
+    }
+
+    bool async_file::is_open() const noexcept
+    {
+        return _handle != -1;
+    }
+
+    void async_file::close()
+    {
+        assert(is_open());
+
+        wait_all();
+        _engine.reset();
+        ::close(_handle);
+        _handle = -1;
+    }
+
+    async_file_backend async_file::backend() const noexcept
+    {
+        assert(is_open());
+        return _engine->backend();
+    }
+
+    void async_file::read_at(stream_position position, span<byte> buffer, async_completion completion)
+    {
+        assert(is_open());
+        _engine->enqueue(std::make_unique<async_request>(false, position, buffer.data(), buffer.size(), stdext::move(completion)));
+    }
+
+    void async_file::write_at(stream_position position, span<const byte> buffer, async_completion completion)
+    {
+        assert(is_open());
+        _engine->enqueue(std::make_unique<async_request>(true, position, const_cast<byte*>(buffer.data()), buffer.size(), stdext::move(completion)));
+    }
+
+    size_t async_file::submit()
+    {
+        assert(is_open());
+        return _engine->submit();
+    }
+
+    size_t async_file::poll()
+    {
+        assert(is_open());
+        return _engine->reap(0);
+    }
+
+    size_t async_file::wait(size_t count)
+    {
+        assert(is_open());
+        _engine->submit();
+        return _engine->reap(std::min(count, _engine->pending()));
+    }
+
+    void async_file::wait_all()
+    {
+        assert(is_open());
+        while (_engine->pending() != 0)
+            wait(_engine->pending());
+    }
+
+    size_t async_file::pending() const noexcept
+    {
+        return is_open() ? _engine->pending() : 0;
+    }
+
+    namespace
+    {
+        // Returns null if the requested backend is unavailable.
+        std::unique_ptr<async_engine> make_engine([[maybe_unused]] int fd, unsigned queue_depth, async_file_backend backend)
+        {
+#if STDEXT_HAS_IO_URING
+            if (backend != async_file_backend::thread_pool)
+            {
+                if (auto engine = io_uring_engine::create(fd, std::min(queue_depth, max_ring_entries)))
+                    return engine;
+            }
+#endif
+
+            if (backend == async_file_backend::io_uring)
+                return nullptr;
+
+            return std::make_unique<thread_pool_engine>(fd, std::min(queue_depth, max_worker_threads));
+        }
+    }
+}
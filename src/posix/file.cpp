@@ -1,4 +1,5 @@
 #include <stdext/file.h>
+#include <stdext/scope_guard.h>
 #include <stdext/unicode.h>
 
 #include <algorithm>
@@ -6,7 +7,11 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "open_flags.h"
 
 
 namespace stdext
@@ -39,7 +44,11 @@ namespace stdext
             file_handle_t handle;
         };
 
-        int creation_disposition(flags<file_open_flags> flags);
+        // Vectored transfers are submitted in batches of at most this many buffers, well
+        // within any system's IOV_MAX.
+        constexpr size_t max_iovec_count = 64;
+
+        int access_advice(mapped_file_access access);
     }
 
     namespace _private
@@ -118,6 +127,28 @@ namespace stdext
                 throw std::system_error(errno, std::generic_category());
         }
 
+        size_t file_stream_base::read_at_impl(stream_position position, byte* buffer, size_t size) const
+        {
+            assert(is_open());
+
+            auto bytes = ::pread(handle, buffer, size, off_t(position));
+            if (bytes == -1)
+                throw std::system_error(errno, std::generic_category());
+
+            return bytes;
+        }
+
+        size_t file_stream_base::write_at_impl(stream_position position, const byte* buffer, size_t size)
+        {
+            assert(is_open());
+
+            auto bytes = ::pwrite(handle, buffer, size, off_t(position));
+            if (bytes == -1)
+                throw std::system_error(errno, std::generic_category());
+
+            return bytes;
+        }
+
         template <typename Stream>
         size_t file_input_stream_base<Stream>::do_read(byte* buffer, size_t size)
         {
@@ -135,19 +166,85 @@ namespace stdext
         {
             assert(self().is_open());
 
+            if (_skip_mode == skip_mode::unknown)
+            {
+                struct stat st;
+                if (::fstat(self().handle, &st) == -1)
+                    throw std::system_error(errno, std::generic_category());
+
+                _skip_mode = S_ISREG(st.st_mode) ? skip_mode::seek : skip_mode::read;
+                _end_hint = st.st_size;
+            }
+
+            if (_skip_mode == skip_mode::read)
+                return skip_by_reading(size);
+
+            // A skip no longer than the file can't overflow the offset, so the common case is a
+            // single relative seek.
+            stream_position start;
+            if (size <= _end_hint)
+            {
+                auto position = ::lseek(self().handle, off_t(size), SEEK_CUR);
+                if (position == -1)
+                    throw std::system_error(errno, std::generic_category());
+
+                if (stream_position(position) <= _end_hint)
+                    return size;
+
+                start = stream_position(position) - size;
+            }
+            else
+            {
+                auto position = ::lseek(self().handle, 0, SEEK_CUR);
+                if (position == -1)
+                    throw std::system_error(errno, std::generic_category());
+
+                start = stream_position(position);
+            }
+
+            // The skip goes past the end of the file as last observed; the file may have grown.
             struct stat st;
-            if (fstat(self().handle, &st) == -1)
+            if (::fstat(self().handle, &st) == -1)
                 throw std::system_error(errno, std::generic_category());
 
-            auto distance = lseek(self().handle, 0, SEEK_CUR);
-            if (distance == -1)
+            _end_hint = st.st_size;
+            auto skipped = start < _end_hint ? std::min(stream_position(size), _end_hint - start) : 0;
+            if (::lseek(self().handle, off_t(start + skipped), SEEK_SET) == -1)
                 throw std::system_error(errno, std::generic_category());
 
-            distance = std::min(size, size_t(st.st_size - distance));
-            if (lseek(self().handle, distance, SEEK_CUR) == -1)
-                throw std::system_error(errno, std::generic_category());
+            return size_t(skipped);
+        }
+
+        template <typename Stream>
+        size_t file_input_stream_base<Stream>::do_read_vectored(span<const span<byte>> buffers)
+        {
+            assert(self().is_open());
+
+            size_t bytes = 0;
+            while (!buffers.empty())
+            {
+                iovec iov[max_iovec_count];
+                auto count = std::min(buffers.size(), max_iovec_count);
+                size_t expected = 0;
+                for (size_t n = 0; n != count; ++n)
+                {
+                    iov[n].iov_base = buffers[n].data();
+                    iov[n].iov_len = buffers[n].size();
+                    expected += buffers[n].size();
+                }
+
+                auto result = ::readv(self().handle, iov, int(count));
+                if (result == -1)
+                    throw std::system_error(errno, std::generic_category());
+
+                bytes += result;
+                if (size_t(result) != expected)
+                    break;
+
+                buffers = buffers.subspan(count);
+            }
 
-            return static_cast<size_t>(distance);
+            return bytes;
         }
 
         template <typename Stream>
@@ -161,6 +258,143 @@ namespace stdext
 
             return bytes;
         }
+
+        template <typename Stream>
+        size_t file_output_stream_base<Stream>::do_write_vectored(span<const span<const byte>> buffers)
+        {
+            assert(self().is_open());
+
+            size_t bytes = 0;
+            while (!buffers.empty())
+            {
+                iovec iov[max_iovec_count];
+                auto count = std::min(buffers.size(), max_iovec_count);
+                size_t expected = 0;
+                for (size_t n = 0; n != count; ++n)
+                {
+                    iov[n].iov_base = const_cast<byte*>(buffers[n].data());
+                    iov[n].iov_len = buffers[n].size();
+                    expected += buffers[n].size();
+                }
+
+                auto result = ::writev(self().handle, iov, int(count));
+                if (result == -1)
+                    throw std::system_error(errno, std::generic_category());
+
+                bytes += result;
+                if (size_t(result) != expected)
+                    break;
+
+                buffers = buffers.subspan(count);
+            }
+
+            return bytes;
+        }
+
+        file_mapping::file_mapping(file_mapping&& other) noexcept
+            : _data(stdext::exchange(other._data, nullptr)), _size(stdext::exchange(other._size, 0)), _open(stdext::exchange(other._open, false))
+        {
+        }
+
+        file_mapping& file_mapping::operator = (file_mapping&& other) noexcept
+        {
+            if (is_open())
+                close();
+
+            _data = stdext::exchange(other._data, nullptr);
+            _size = stdext::exchange(other._size, 0);
+            _open = stdext::exchange(other._open, false);
+            return *this;
+        }
+
+        file_mapping::~file_mapping()
+        {
+            if (is_open())
+                close();
+        }
+
+        std::error_code file_mapping::open(const path_char* path, bool writable, mapped_file_access access, flags<mapped_file_flags> flags)
+        {
+            assert(!is_open());
+
+            auto fd = ::open(path, writable ? O_RDWR : O_RDONLY);
+            if (fd == -1)
+                return { errno, std::generic_category() };
+            at_scope_exit([&] { ::close(fd); });
+
+            struct stat st;
+            if (::fstat(fd, &st) == -1)
+                return { errno, std::generic_category() };
+
+            // mmap rejects empty mappings, so an empty file is left unmapped.
+            if (st.st_size != 0)
+            {
+                auto size = size_t(st.st_size);
+                auto data = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+                if (data == MAP_FAILED)
+                    return { errno, std::generic_category() };
+
+                _data = static_cast<byte*>(data);
+                _size = size;
+
+                if (access != mapped_file_access::normal)
+                {
+                    if (auto error = ::posix_madvise(_data, _size, access_advice(access)); error != 0)
+                    {
+                        close();
+                        return { error, std::generic_category() };
+                    }
+                }
+
+#ifdef MADV_HUGEPAGE
+                // This is only a hint; not all file systems can back a file mapping with huge pages.
+                if (flags.test_any(mapped_file_flags::large_pages))
+                    ::madvise(_data, _size, MADV_HUGEPAGE);
+#else
+                discard(flags);
+#endif
+            }
+
+            _open = true;
+            return { };
+        }
+
+        std::error_code file_mapping::open(const char* path, utf8_path_encoding, bool writable, mapped_file_access access, flags<mapped_file_flags> flags)
+        {
+            return open(path, writable, access, flags);
+        }
+
+        void file_mapping::close() noexcept
+        {
+            if (_data != nullptr)
+                ::munmap(_data, _size);
+
+            _data = nullptr;
+            _size = 0;
+            _open = false;
+        }
+
+        void file_mapping::advise(mapped_file_access access)
+        {
+            assert(is_open());
+
+            if (_size == 0)
+                return;
+
+            if (auto error = ::posix_madvise(_data, _size, access_advice(access)); error != 0)
+                throw std::system_error(error, std::generic_category());
+        }
+
+        void file_mapping::flush()
+        {
+            assert(is_open());
+
+            if (_size == 0)
+                return;
+
+            if (::msync(_data, _size, MS_SYNC) == -1)
+                throw std::system_error(errno, std::generic_category());
+        }
     }
 
     file_input_stream::file_input_stream(const path_char* path)
@@ -183,6 +417,7 @@ namespace stdext
         if (handle == -1)
             return { errno, std::generic_category() };
 
+        reset_skip_state();
         return { };
     }
 
@@ -192,7 +427,7 @@ namespace stdext
     }
 
     file_output_stream::file_output_stream(const path_char* path, flags<file_open_flags> flags)
-        : file_stream_base(::open(path, O_WRONLY | creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
+        : file_stream_base(::open(path, O_WRONLY | _private::creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
     {
     }
 
@@ -207,7 +442,7 @@ namespace stdext
     {
         assert(!is_open());
 
-        handle = ::open(path, O_WRONLY | creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        handle = ::open(path, O_WRONLY | _private::creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         if (handle == -1)
             return { errno, std::generic_category() };
 
@@ -220,7 +455,7 @@ namespace stdext
     }
 
     file_stream::file_stream(const path_char* path, flags<file_open_flags> flags)
-        : file_stream_base(::open(path, O_RDWR | creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
+        : file_stream_base(::open(path, O_RDWR | _private::creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
     {
     }
 
@@ -235,10 +470,11 @@ namespace stdext
     {
         assert(!is_open());
 
-        handle = ::open(path, O_RDWR | creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        handle = ::open(path, O_RDWR | _private::creation_disposition(flags), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
         if (handle == -1)
             return { errno, std::generic_category() };
 
+        reset_skip_state();
         return { };
     }
 
@@ -247,6 +483,114 @@ namespace stdext
         return open(path, flags);
     }
 
+    mapped_file_input_stream::mapped_file_input_stream(mapped_file_input_stream&& other) noexcept
+        : memory_stream_base<const byte*>(other), _mapping(stdext::move(other._mapping))
+    {
+        other.reset();
+    }
+
+    mapped_file_input_stream& mapped_file_input_stream::operator = (mapped_file_input_stream&& other) noexcept
+    {
+        memory_stream_base<const byte*>::operator = (other);
+        _mapping = stdext::move(other._mapping);
+        other.reset();
+        return *this;
+    }
+
+    mapped_file_input_stream::~mapped_file_input_stream() = default;
+
+    mapped_file_input_stream::mapped_file_input_stream(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, access, flags))
+            throw std::system_error(error);
+    }
+
+    mapped_file_input_stream::mapped_file_input_stream(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, utf8_path_encoding(), access, flags))
+            throw std::system_error(error);
+    }
+
+    std::error_code mapped_file_input_stream::open(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, false, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    std::error_code mapped_file_input_stream::open(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, utf8_path_encoding(), false, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    void mapped_file_input_stream::close() noexcept
+    {
+        assert(is_open());
+
+        reset();
+        _mapping.close();
+    }
+
+    mapped_file_stream::mapped_file_stream(mapped_file_stream&& other) noexcept
+        : memory_stream_base<byte*>(other), _mapping(stdext::move(other._mapping))
+    {
+        other.reset();
+    }
+
+    mapped_file_stream& mapped_file_stream::operator = (mapped_file_stream&& other) noexcept
+    {
+        memory_stream_base<byte*>::operator = (other);
+        _mapping = stdext::move(other._mapping);
+        other.reset();
+        return *this;
+    }
+
+    mapped_file_stream::~mapped_file_stream() = default;
+
+    mapped_file_stream::mapped_file_stream(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, access, flags))
+            throw std::system_error(error);
+    }
+
+    mapped_file_stream::mapped_file_stream(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, utf8_path_encoding(), access, flags))
+            throw std::system_error(error);
+    }
+
+    std::error_code mapped_file_stream::open(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, true, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    std::error_code mapped_file_stream::open(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, utf8_path_encoding(), true, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    void mapped_file_stream::close() noexcept
+    {
+        assert(is_open());
+
+        reset();
+        _mapping.close();
+    }
+
     input_stream& in()
     {
         static std_input_stream in(STDIN_FILENO);
@@ -267,24 +611,19 @@ namespace stdext
 
     namespace
     {
-        int creation_disposition(flags<file_open_flags> flags)
+        int access_advice(mapped_file_access access)
         {
-            // The static_cast is here to work around a Visual Studio 2015 bug.
-            switch (static_cast<file_open_flags>(flags))
+            switch (access)
             {
-            case file_open_flags::none:
-                return 0;
-            case file_open_flags::create:
-                return O_CREAT;
-            case file_open_flags::create_exclusive:
-                return O_CREAT | O_EXCL;
-            case file_open_flags::truncate:
-                return O_TRUNC;
-            case stdext::flags<file_open_flags>(file_open_flags::create, file_open_flags::truncate):
-                return O_CREAT | O_TRUNC;
+            case mapped_file_access::normal:
+                return POSIX_MADV_NORMAL;
+            case mapped_file_access::sequential:
+                return POSIX_MADV_SEQUENTIAL;
+            case mapped_file_access::random:
+                return POSIX_MADV_RANDOM;
             }
 
-            return -1;
+            unreachable();
         }
     }
 }
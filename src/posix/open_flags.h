@@ -0,0 +1,37 @@
+#ifndef STDEXT_IMPL_OPEN_FLAGS_INCLUDED
+#define STDEXT_IMPL_OPEN_FLAGS_INCLUDED
+#pragma once
+
+#include <stdext/file.h>
+
+#include <fcntl.h>
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        // The open flags that carry out file_open_flags.
+        inline int creation_disposition(flags<file_open_flags> flags) noexcept
+        {
+            // The static_cast is here to work around a Visual Studio 2015 bug.
+            switch (static_cast<file_open_flags>(flags))
+            {
+            case file_open_flags::none:
+                return 0;
+            case file_open_flags::create:
+                return O_CREAT;
+            case file_open_flags::create_exclusive:
+                return O_CREAT | O_EXCL;
+            case file_open_flags::truncate:
+                return O_TRUNC;
+            case stdext::flags<file_open_flags>(file_open_flags::create, file_open_flags::truncate):
+                return O_CREAT | O_TRUNC;
+            }
+
+            return -1;
+        }
+    }
+}
+
+#endif
@@ -23,6 +23,49 @@ namespace stdext
     memory_output_stream::~memory_output_stream() = default;
     memory_stream::~memory_stream() = default;
     substream::~substream() = default;
+    buffered_input_stream::~buffered_input_stream() = default;
+
+    buffered_output_stream::~buffered_output_stream()
+    {
+        if (is_attached())
+        {
+            try
+            {
+                flush();
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    size_t input_stream::do_read_vectored(span<const span<byte>> buffers)
+    {
+        size_t bytes = 0;
+        for (auto& buffer : buffers)
+        {
+            auto size = do_read(buffer.data(), buffer.size());
+            bytes += size;
+            if (size != buffer.size())
+                break;
+        }
+
+        return bytes;
+    }
+
+    size_t output_stream::do_write_vectored(span<const span<const byte>> buffers)
+    {
+        size_t bytes = 0;
+        for (auto& buffer : buffers)
+        {
+            auto size = do_write(buffer.data(), buffer.size());
+            bytes += size;
+            if (size != buffer.size())
+                break;
+        }
+
+        return bytes;
+    }
 
     stream_position seekable::seek(seek_from from, stream_offset offset)
     {
@@ -48,6 +91,405 @@ namespace stdext
         return p;
     }
 
+    void buffered_input_stream::attach(input_stream& stream, size_t buffer_size)
+    {
+        assert(buffer_size != 0);
+
+        if (buffer_size != _capacity)
+        {
+            _buffer = std::make_unique<byte[]>(buffer_size);
+            _capacity = buffer_size;
+        }
+
+        _stream = &stream;
+        _first = _last = 0;
+    }
+
+    size_t buffered_input_stream::direct_read(std::function<size_t (const byte* buffer, size_t size)> read)
+    {
+        assert(is_attached());
+
+        if (_first == _last)
+            fill();
+
+        auto size = read(_buffer.get() + _first, _last - _first);
+        assert(size <= _last - _first);
+        _first += size;
+        return size;
+    }
+
+    size_t buffered_input_stream::do_read(byte* buffer, size_t size)
+    {
+        assert(is_attached());
+
+        size_t bytes = 0;
+        while (size != 0)
+        {
+            if (_first == _last)
+            {
+                if (size >= _capacity)
+                {
+                    auto chunk = _stream->read(buffer, size);
+                    if (chunk == 0)
+                        break;
+
+                    buffer += chunk;
+                    bytes += chunk;
+                    size -= chunk;
+                    continue;
+                }
+
+                if (fill() == 0)
+                    break;
+            }
+
+            auto chunk = std::min(size, _last - _first);
+            buffer = std::copy_n(_buffer.get() + _first, chunk, buffer);
+            _first += chunk;
+            bytes += chunk;
+            size -= chunk;
+        }
+
+        return bytes;
+    }
+
+    size_t buffered_input_stream::do_skip(size_t size)
+    {
+        assert(is_attached());
+
+        auto bytes = std::min(size, _last - _first);
+        _first += bytes;
+        if (bytes == size)
+            return bytes;
+
+        return bytes + _stream->skip<byte>(size - bytes);
+    }
+
+    size_t buffered_input_stream::do_peek(byte* buffer, size_t size)
+    {
+        assert(is_attached());
+
+        size = std::min(size, _capacity);
+        while (_last - _first < size)
+        {
+            if (fill() == 0)
+                break;
+        }
+
+        size = std::min(size, _last - _first);
+        std::copy_n(_buffer.get() + _first, size, buffer);
+        return size;
+    }
+
+    size_t buffered_input_stream::fill()
+    {
+        // Slide any unread data to the front of the buffer to make room.
+        if (_first != 0)
+        {
+            std::copy(_buffer.get() + _first, _buffer.get() + _last, _buffer.get());
+            _last -= _first;
+            _first = 0;
+        }
+
+        auto bytes = _stream->read(_buffer.get() + _last, _capacity - _last);
+        _last += bytes;
+        return bytes;
+    }
+
+    buffered_output_stream& buffered_output_stream::operator = (buffered_output_stream&& other)
+    {
+        if (is_attached())
+            flush();
+
+        _stream = stdext::exchange(other._stream, nullptr);
+        _buffer = stdext::move(other._buffer);
+        _capacity = stdext::exchange(other._capacity, 0);
+        _last = stdext::exchange(other._last, 0);
+        return *this;
+    }
+
+    void buffered_output_stream::attach(output_stream& stream, size_t buffer_size)
+    {
+        assert(buffer_size != 0);
+
+        if (is_attached())
+            flush();
+
+        if (buffer_size != _capacity)
+        {
+            _buffer = std::make_unique<byte[]>(buffer_size);
+            _capacity = buffer_size;
+        }
+
+        _stream = &stream;
+    }
+
+    void buffered_output_stream::detach()
+    {
+        if (is_attached())
+            flush();
+
+        _stream = nullptr;
+    }
+
+    void buffered_output_stream::flush()
+    {
+        assert(is_attached());
+
+        _stream->write_all(_buffer.get(), _last);
+        _last = 0;
+    }
+
+    size_t buffered_output_stream::direct_write(std::function<size_t (byte* buffer, size_t size)> write)
+    {
+        assert(is_attached());
+
+        if (_last == _capacity)
+            flush();
+
+        auto size = write(_buffer.get() + _last, _capacity - _last);
+        assert(size <= _capacity - _last);
+        _last += size;
+        return size;
+    }
+
+    size_t buffered_output_stream::do_write(const byte* buffer, size_t size)
+    {
+        assert(is_attached());
+
+        if (size >= _capacity)
+        {
+            flush();
+            return _stream->write(buffer, size);
+        }
+
+        if (size > _capacity - _last)
+            flush();
+
+        std::copy_n(buffer, size, _buffer.get() + _last);
+        _last += size;
+        return size;
+    }
+
+    memory_segment_pool::~memory_segment_pool()
+    {
+        assert(_outstanding == 0);
+        trim();
+    }
+
+    void memory_segment_pool::trim() noexcept
+    {
+        while (_free != nullptr)
+        {
+            auto next = _free->next;
+            _free->~segment();
+            ::operator delete(_free);
+            _free = next;
+        }
+    }
+
+    memory_segment_pool::segment* memory_segment_pool::allocate()
+    {
+        segment* s;
+        if (_free != nullptr)
+        {
+            s = _free;
+            _free = s->next;
+            s->next = nullptr;
+        }
+        else
+            s = new (::operator new(sizeof(segment) + _segment_size)) segment{ nullptr };
+
+        ++_outstanding;
+        return s;
+    }
+
+    void memory_segment_pool::release(segment* s) noexcept
+    {
+        s->next = _free;
+        _free = s;
+        --_outstanding;
+    }
+
+    segmented_memory_stream& segmented_memory_stream::operator = (segmented_memory_stream&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+
+        _pool = stdext::exchange(other._pool, nullptr);
+        _head = stdext::exchange(other._head, nullptr);
+        _tail = stdext::exchange(other._tail, nullptr);
+        _read_offset = stdext::exchange(other._read_offset, 0);
+        _write_offset = stdext::exchange(other._write_offset, 0);
+        _size = stdext::exchange(other._size, 0);
+        return *this;
+    }
+
+    segmented_memory_stream::~segmented_memory_stream()
+    {
+        clear();
+    }
+
+    void segmented_memory_stream::clear() noexcept
+    {
+        while (_head != nullptr)
+            _pool->release(stdext::exchange(_head, _head->next));
+
+        _tail = nullptr;
+        _read_offset = _write_offset = 0;
+        _size = 0;
+    }
+
+    size_t segmented_memory_stream::write_to(output_stream& stream)
+    {
+        // Vectored writes are issued in batches of at most this many segments.
+        constexpr size_t max_batch_count = 64;
+
+        size_t bytes = 0;
+        while (_size != 0)
+        {
+            span<const byte> buffers[max_batch_count];
+            size_t count = 0;
+            size_t batch_size = 0;
+            auto offset = _read_offset;
+            for (auto s = _head; s != nullptr && count != max_batch_count; s = s->next)
+            {
+                auto end = s == _tail ? _write_offset : _pool->segment_size();
+                if (end != offset)
+                {
+                    buffers[count++] = { s->data() + offset, end - offset };
+                    batch_size += end - offset;
+                }
+                offset = 0;
+            }
+
+            auto written = stream.write_vectored({ buffers, count });
+            discard(do_skip(written));
+            bytes += written;
+            if (written != batch_size)
+                break;
+        }
+
+        return bytes;
+    }
+
+    size_t segmented_memory_stream::direct_read(std::function<size_t (const byte* buffer, size_t size)> read)
+    {
+        auto extent = readable_extent();
+        auto size = read(extent == 0 ? nullptr : _head->data() + _read_offset, extent);
+        assert(size <= extent);
+        consume(size);
+        return size;
+    }
+
+    size_t segmented_memory_stream::direct_write(std::function<size_t (byte* buffer, size_t size)> write)
+    {
+        assert(_pool != nullptr);
+
+        reserve_tail();
+        auto size = write(_tail->data() + _write_offset, _pool->segment_size() - _write_offset);
+        assert(size <= _pool->segment_size() - _write_offset);
+        _write_offset += size;
+        _size += size;
+        return size;
+    }
+
+    size_t segmented_memory_stream::do_read(byte* buffer, size_t size)
+    {
+        size_t bytes = 0;
+        while (bytes != size)
+        {
+            auto chunk = std::min(size - bytes, readable_extent());
+            if (chunk == 0)
+                break;
+
+            std::copy_n(_head->data() + _read_offset, chunk, buffer + bytes);
+            consume(chunk);
+            bytes += chunk;
+        }
+
+        return bytes;
+    }
+
+    size_t segmented_memory_stream::do_skip(size_t size)
+    {
+        size_t bytes = 0;
+        while (bytes != size)
+        {
+            auto chunk = std::min(size - bytes, readable_extent());
+            if (chunk == 0)
+                break;
+
+            consume(chunk);
+            bytes += chunk;
+        }
+
+        return bytes;
+    }
+
+    size_t segmented_memory_stream::do_write(const byte* buffer, size_t size)
+    {
+        assert(_pool != nullptr);
+
+        auto remaining = size;
+        while (remaining != 0)
+        {
+            reserve_tail();
+            auto chunk = std::min(remaining, _pool->segment_size() - _write_offset);
+            std::copy_n(buffer, chunk, _tail->data() + _write_offset);
+            buffer += chunk;
+            remaining -= chunk;
+            _write_offset += chunk;
+            _size += chunk;
+        }
+
+        return size;
+    }
+
+    // The number of unread bytes that are contiguous in the first segment.
+    size_t segmented_memory_stream::readable_extent() const noexcept
+    {
+        if (_head == nullptr)
+            return 0;
+
+        return (_head == _tail ? _write_offset : _pool->segment_size()) - _read_offset;
+    }
+
+    void segmented_memory_stream::consume(size_t size) noexcept
+    {
+        _read_offset += size;
+        _size -= size;
+
+        if (_head == _tail)
+        {
+            // Once everything has been read, the remaining segment can be reused from the start.
+            if (_read_offset == _write_offset)
+                _read_offset = _write_offset = 0;
+        }
+        else if (_read_offset == _pool->segment_size())
+        {
+            _pool->release(stdext::exchange(_head, _head->next));
+            _read_offset = 0;
+        }
+    }
+
+    void segmented_memory_stream::reserve_tail()
+    {
+        if (_tail != nullptr && _write_offset != _pool->segment_size())
+            return;
+
+        auto s = _pool->allocate();
+        if (_tail == nullptr)
+            _head = s;
+        else
+            _tail->next = s;
+
+        _tail = s;
+        _write_offset = 0;
+    }
+
     extern string_stream_consumer& strout()
     {
         static string_stream_consumer strout(out());
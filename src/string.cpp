@@ -7,35 +7,144 @@
 //
 
 #include <stdext/string.h>
+#include <stdext/unicode.h>
 
 #include <stdexcept>
 
+#include <cstring>
 #include <cwchar>
 
 
 namespace stdext
 {
-    std::string to_mbstring(const wchar_t* str)
+    namespace
     {
-        std::mbstate_t state = {};
-        auto length = std::wcsrtombs(nullptr, &str, 0, &state);
-        if (length == size_t(-1))
+        // The UTF type with the same representation as wchar_t, when there is one.
+        using wide_utf_char = std::conditional_t<_private::utf16_wide_charset, char16_t, char32_t>;
+
+        template <typename Char>
+        utf_conversion_result utf8_to_wide(span<const char> in, span<Char> out, utfstate_t& state)
+        {
+            if constexpr (std::is_same_v<Char, char16_t>)
+                return to_utf16(in, out, state);
+            else
+                return to_utf32(in, out, state);
+        }
+
+        [[noreturn]] void throw_conversion_error()
+        {
             throw std::runtime_error("Character encoding conversion error");
+        }
+
+        // The bulk UTF conversions reject noncharacters, which the locale-based conversions
+        // accept as the valid scalar values they are.  When a bulk conversion fails, the input is
+        // converted again by these, which reject only ill-formed sequences, surrogate code points
+        // and values above U+10FFFF.
+        std::string to_utf8_allowing_noncharacters(span<const wide_utf_char> in)
+        {
+            std::string result;
+            result.reserve(in.size());
+
+            _private::utf8_mbstate state;
+            for (auto c : in)
+            {
+                char buffer[MAX_UTF8_CHARACTER_LENGTH];
+                auto length = _private::to_mb(buffer, c, &state);
+                if (length == size_t(-1))
+                    throw_conversion_error();
+                result.append(buffer, length);
+            }
+
+            if (state.lead != 0)
+                throw_conversion_error();
+            return result;
+        }
+
+        // Writes at most in.size() code units to out and returns the number written.
+        size_t to_wide_allowing_noncharacters(span<const char> in, wide_utf_char* out)
+        {
+            constexpr char32_t minimum_code[] = { 0, 0, 0x80, 0x800, 0x10000 };
+
+            auto q = out;
+            for (size_t i = 0; i != in.size(); )
+            {
+                auto length = utf8_character_length(in[i]);
+                if (length == 0 || length > in.size() - i)
+                    throw_conversion_error();
+
+                char32_t code = uint8_t(in[i]) & (length == 1 ? 0x7F : 0x7F >> length);
+                for (size_t n = 1; n != length; ++n)
+                {
+                    if (!utf8_is_trailing(in[i + n]))
+                        throw_conversion_error();
+                    code = code << 6 | (uint8_t(in[i + n]) & 0x3F);
+                }
 
-        std::string result(length, '\0');
-        std::wcsrtombs(result.data(), &str, length, &state);
-        return result;
+                if (code < minimum_code[length] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+                    throw_conversion_error();
+                i += length;
+
+                if (std::is_same_v<wide_utf_char, char16_t> && code >= 0x10000)
+                {
+                    code -= 0x10000;
+                    *q++ = wide_utf_char(0xD800 | code >> 10);
+                    *q++ = wide_utf_char(0xDC00 | (code & 0x03FF));
+                }
+                else
+                    *q++ = wide_utf_char(code);
+            }
+
+            return size_t(q - out);
+        }
+    }
+
+    std::string to_mbstring(const wchar_t* str)
+    {
+        if constexpr (_private::utf_execution_charsets)
+        {
+            auto in = span<const wide_utf_char>(reinterpret_cast<const wide_utf_char*>(str), std::wcslen(str));
+            auto [result, mbstr] = to_u8string(in);
+            if (result != utf_result::ok)
+                return to_utf8_allowing_noncharacters(in);
+            return stdext::move(mbstr);
+        }
+        else
+        {
+            std::mbstate_t state = {};
+            auto length = std::wcsrtombs(nullptr, &str, 0, &state);
+            if (length == size_t(-1))
+                throw_conversion_error();
+
+            std::string result(length, '\0');
+            std::wcsrtombs(result.data(), &str, length, &state);
+            return result;
+        }
     }
 
     std::wstring to_wstring(const char* str)
     {
-        std::mbstate_t state = {};
-        auto length = std::mbsrtowcs(nullptr, &str, 0, &state);
-        if (length == size_t(-1))
-            throw std::runtime_error("Character encoding conversion error");
+        if constexpr (_private::utf_execution_charsets)
+        {
+            // Decoding UTF-8 never produces more code units than it consumes, so a single pass
+            // into a buffer of the input's length suffices.
+            auto in = span<const char>(str, std::strlen(str));
+            std::wstring result(in.size(), L'\0');
+            auto out = span<wide_utf_char>(reinterpret_cast<wide_utf_char*>(result.data()), result.size());
+            utfstate_t state = { };
+            auto converted = utf8_to_wide(in, out, state);
+            result.resize(converted.result == utf_result::ok ? converted.written : to_wide_allowing_noncharacters(in, out.data()));
+            return result;
+        }
+        else
+        {
+            std::mbstate_t state = {};
+            auto length = std::mbsrtowcs(nullptr, &str, 0, &state);
+            if (length == size_t(-1))
+                throw_conversion_error();
 
-        std::wstring result(length, '\0');
-        std::mbsrtowcs(result.data(), &str, length, &state);
-        return result;
+            std::wstring result(length, '\0');
+            std::mbsrtowcs(result.data(), &str, length, &state);
+            return result;
+        }
     }
 }
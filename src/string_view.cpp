@@ -1,107 +1,145 @@
 #include <stdext/string_view.h>
-#include <stdext/scope_guard.h>
 
 #include <cctype>
 
+#if STDEXT_ARCH_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STDEXT_STRING_VIEW_SSE2 1
+#include <emmintrin.h>
+#else
+#define STDEXT_STRING_VIEW_SSE2 0
+#endif
+
+#if STDEXT_ARCH_ARM64 && defined(__ARM_NEON)
+#define STDEXT_STRING_VIEW_NEON 1
+#include <arm_neon.h>
+#else
+#define STDEXT_STRING_VIEW_NEON 0
+#endif
+
 
 namespace stdext
 {
     namespace
     {
-        template <typename Int>
-        Int ston(string_view str, size_t* idx, int base)
+        // Flips the case of the ASCII letters in [first, first + 26), which must be 'A' or 'a'.
+        char ascii_flip_case(char c, char first) noexcept
         {
-            using UInt = std::make_unsigned_t<Int>;
-            using SInt = std::make_signed_t<Int>;
+            return uint8_t(c - first) < 26 ? char(c ^ 0x20) : c;
+        }
 
-            auto p = find_if_not(str, isspace);
-            if (str.is_end_pos(p))
-                throw std::invalid_argument("invalid numeric string");
+        void ascii_map_case(const char* p, size_t size, char* out, char first) noexcept
+        {
+            size_t n = 0;
 
-            bool negative = false;
-            switch (str.at_pos(p))
+#if STDEXT_STRING_VIEW_SSE2
+            // Shift the letters to the bottom of the signed range so that a single signed
+            // comparison picks them out.
+            auto bias = _mm_set1_epi8(char(0x80 - first));
+            auto limit = _mm_set1_epi8(char(0x80 + 26));
+            auto bit = _mm_set1_epi8(0x20);
+            for (; size - n >= 16; n += 16)
             {
-                case '-':
-                    negative = true;
-                    [[fallthrough]];
-                case '+':
-                    str.inc_pos(p);
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+                auto letters = _mm_cmplt_epi8(_mm_add_epi8(v, bias), limit);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm_xor_si128(v, _mm_and_si128(letters, bit)));
             }
-
-            bool valid = false;
-            auto q = p;
-            at_scope_success([&]
+#elif STDEXT_STRING_VIEW_NEON
+            auto base = vdupq_n_u8(uint8_t(first));
+            auto limit = vdupq_n_u8(26);
+            auto bit = vdupq_n_u8(0x20);
+            for (; size - n >= 16; n += 16)
             {
-                if (idx != nullptr)
-                    *idx = str.distance(str.begin_pos(), q);
-            });
-            if (base == 0 || base == 16)
+                auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + n));
+                auto letters = vcltq_u8(vsubq_u8(v, base), limit);
+                vst1q_u8(reinterpret_cast<uint8_t*>(out + n), veorq_u8(v, vandq_u8(letters, bit)));
+            }
+#endif
+
+            for (; n != size; ++n)
+                out[n] = ascii_flip_case(p[n], first);
+        }
+
+        const char* skip_space(string_view str) noexcept
+        {
+            return std::find_if_not(str.data(), str.data() + str.size(), [](char c) { return isspace(uint8_t(c)) != 0; });
+        }
+
+        template <typename Int>
+        Int ston(string_view str, size_t* idx, int base)
+        {
+            auto first = str.data();
+            auto last = first + str.size();
+            auto p = skip_space(str);
+
+            bool negative = false;
+            if (p != last && (*p == '-' || *p == '+'))
+                negative = *p++ == '-';
+
+            auto start = p;
+            if ((base == 0 || base == 16) && p != last && *p == '0')
             {
-                if (str.at_pos(p) == '0')
+                if (last - p > 1 && (p[1] == 'x' || p[1] == 'X'))
                 {
-                    valid = true;
-                    q = str.inc_pos(p);
-                    if (str.at_pos(p) == 'x' || str.at_pos(p) == 'X')
-                    {
-                        base = 16;
-                        str.inc_pos(p);
-                    }
-                    else if (base == 0)
+                    base = 16;
+                    p += 2;
+                }
+                else if (base == 0)
+                {
+                    base = 8;
+                    if (last - p > 1 && p[1] == 'b')
                     {
-                        if (str.at_pos(p) == 'b')
-                        {
-                            base = 2;
-                            str.inc_pos(p);
-                        }
-                        else
-                            base = 8;
+                        base = 2;
+                        p += 2;
                     }
                 }
-
-                if (base == 0)
-                    base = 10;
             }
 
-            UInt value = 0;
-            for (; !str.is_end_pos(p); q = str.inc_pos(p))
+            if (base == 0)
+                base = 10;
+
+            auto result = _private::parse_unsigned(p, last, base);
+            if (result.ec == std::errc::invalid_argument && p != start)
             {
-                int c = str.at_pos(p);
-                if (c >= '0' && c <= '9')
-                    c -= '0';
-                else if (c >= 'A' && c <= 'Z')
-                    c -= 'A' - 10;
-                else if (c >= 'a' && c <= 'z')
-                    c -= 'a' - 10;
-                else
-                    break;
-
-                if (c >= base)
-                    break;
-
-                UInt v = base * value + c;
-                if (v < value)
-                    throw std::out_of_range("numeric value too large");
-
-                value = v;
-                valid = true;
+                // A prefix with no digits after it is just a zero.
+                p = start;
+                result = { 0, 1, std::errc() };
             }
-
-            if (!valid)
+            if (result.ec == std::errc::invalid_argument)
                 throw std::invalid_argument("invalid numeric string");
+            if (result.ec == std::errc::result_out_of_range)
+                throw std::out_of_range("numeric value too large");
 
-            SInt result = value;
-            if (result < 0)
+            // Unsigned results wrap on negation, as with strtoul.
+            using UInt = std::make_unsigned_t<Int>;
+            auto limit = uint64_t(std::numeric_limits<Int>::max()) + (std::is_signed_v<Int> && negative);
+            if (result.value > limit)
                 throw std::out_of_range("numeric value too large");
 
-            return negative ? -result : result;
+            if (idx != nullptr)
+                *idx = size_t(p - first) + result.pos;
+            auto value = UInt(result.value);
+            return Int(negative ? UInt(0 - value) : value);
         }
 
-#if 0
         template <typename Float>
         Float stox(string_view str, size_t* idx)
         {
+            auto first = str.data();
+            auto last = first + str.size();
+            auto p = skip_space(str);
+            if (last - p > 1 && *p == '+' && p[1] != '-')
+                ++p;
+
+            auto result = from_chars<Float>(string_view(p, last));
+            if (result.ec == std::errc::invalid_argument)
+                throw std::invalid_argument("invalid numeric string");
+            if (result.ec == std::errc::result_out_of_range)
+                throw std::out_of_range("numeric value too large");
+
+            if (idx != nullptr)
+                *idx = size_t(p - first) + result.pos;
+            return result.value;
         }
-#endif
     }
 
     int stoi(string_view str, size_t* idx, int base)
@@ -129,7 +167,6 @@ namespace stdext
         return ston<unsigned long long>(str, idx, base);
     }
 
-#if 0
     float stof(string_view str, size_t* idx)
     {
         return stox<float>(str, idx);
@@ -144,5 +181,76 @@ namespace stdext
     {
         return stox<long double>(str, idx);
     }
+
+    void ascii_to_lower(string_view str, char* out) noexcept
+    {
+        ascii_map_case(str.data(), str.size(), out, 'A');
+    }
+
+    void ascii_to_upper(string_view str, char* out) noexcept
+    {
+        ascii_map_case(str.data(), str.size(), out, 'a');
+    }
+
+    std::string ascii_to_lower(string_view str)
+    {
+        std::string result(str.size(), '\0');
+        ascii_to_lower(str, result.data());
+        return result;
+    }
+
+    std::string ascii_to_upper(string_view str)
+    {
+        std::string result(str.size(), '\0');
+        ascii_to_upper(str, result.data());
+        return result;
+    }
+
+    bool ascii_equal_ignore_case(string_view a, string_view b) noexcept
+    {
+        if (a.size() != b.size())
+            return false;
+
+        auto p = a.data();
+        auto q = b.data();
+        auto size = a.size();
+        size_t n = 0;
+
+#if STDEXT_STRING_VIEW_SSE2
+        // Bytes that differ only in the case bit are equal if they're letters.
+        auto bias = _mm_set1_epi8(char(0x80 - 'A'));
+        auto limit = _mm_set1_epi8(char(0x80 + 26));
+        auto bit = _mm_set1_epi8(0x20);
+        for (; size - n >= 16; n += 16)
+        {
+            auto u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + n));
+            auto lower_u = _mm_xor_si128(u, _mm_and_si128(_mm_cmplt_epi8(_mm_add_epi8(u, bias), limit), bit));
+            auto lower_v = _mm_xor_si128(v, _mm_and_si128(_mm_cmplt_epi8(_mm_add_epi8(v, bias), limit), bit));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(lower_u, lower_v)) != 0xFFFF)
+                return false;
+        }
+#elif STDEXT_STRING_VIEW_NEON
+        auto base = vdupq_n_u8('A');
+        auto limit = vdupq_n_u8(26);
+        auto bit = vdupq_n_u8(0x20);
+        for (; size - n >= 16; n += 16)
+        {
+            auto u = vld1q_u8(reinterpret_cast<const uint8_t*>(p + n));
+            auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(q + n));
+            auto lower_u = veorq_u8(u, vandq_u8(vcltq_u8(vsubq_u8(u, base), limit), bit));
+            auto lower_v = veorq_u8(v, vandq_u8(vcltq_u8(vsubq_u8(v, base), limit), bit));
+            if (vminvq_u8(vceqq_u8(lower_u, lower_v)) == 0)
+                return false;
+        }
 #endif
+
+        for (; n != size; ++n)
+        {
+            if (ascii_flip_case(p[n], 'A') != ascii_flip_case(q[n], 'A'))
+                return false;
+        }
+
+        return true;
+    }
 }
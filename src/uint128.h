@@ -0,0 +1,46 @@
+#ifndef STDEXT_IMPL_UINT128_INCLUDED
+#define STDEXT_IMPL_UINT128_INCLUDED
+#pragma once
+
+#include <stdext/platform.h>
+
+#include <cstdint>
+
+#if STDEXT_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        struct uint128
+        {
+            uint64_t high;
+            uint64_t low;
+        };
+
+        // The full product of two 64-bit values.
+        inline uint128 multiply(uint64_t a, uint64_t b) noexcept
+        {
+#if defined(__SIZEOF_INT128__)
+            __extension__ using product_type = unsigned __int128;
+            auto product = product_type(a) * b;
+            return { uint64_t(product >> 64), uint64_t(product) };
+#elif STDEXT_COMPILER_MSVC && STDEXT_ARCH_X86_64
+            uint64_t high;
+            auto low = _umul128(a, b, &high);
+            return { high, low };
+#else
+            uint64_t a_low = uint32_t(a), a_high = a >> 32;
+            uint64_t b_low = uint32_t(b), b_high = b >> 32;
+            auto p0 = a_low * b_low, p1 = a_low * b_high, p2 = a_high * b_low, p3 = a_high * b_high;
+            auto middle = (p0 >> 32) + uint32_t(p1) + uint32_t(p2);
+            return { p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32), middle << 32 | uint32_t(p0) };
+#endif
+        }
+    }
+}
+
+#endif
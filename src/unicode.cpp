@@ -1,5 +1,31 @@
 #include <stdext/unicode.h>
 
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cstring>
+
+#if STDEXT_ARCH_X86 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STDEXT_UNICODE_SSE2 1
+#include <emmintrin.h>
+#else
+#define STDEXT_UNICODE_SSE2 0
+#endif
+
+#if STDEXT_UNICODE_SSE2 && (defined(__SSSE3__) || defined(__AVX__))
+#define STDEXT_UNICODE_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define STDEXT_UNICODE_SSSE3 0
+#endif
+
+#if STDEXT_ARCH_ARM64 && defined(__ARM_NEON)
+#define STDEXT_UNICODE_NEON 1
+#include <arm_neon.h>
+#else
+#define STDEXT_UNICODE_NEON 0
+#endif
+
 
 namespace stdext
 {
@@ -8,6 +34,22 @@ namespace stdext
         bool utf8_decode_first(uint8_t code, utfstate_t& state);
         bool utf8_validate_second(uint8_t code, utfstate_t& state);
         bool utf8_decode_trailing(uint8_t code, utfstate_t& state);
+
+        template <typename OutChar>
+        utf_conversion_result utf8_to_utf(span<const char> in, span<OutChar> out, utfstate_t& state, flags<utf_conversion_options> options);
+
+        template <typename InChar>
+        utf_conversion_result utf_to_utf8(span<const InChar> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options);
+        template <typename InChar, typename OutChar>
+        utf_conversion_result utf_to_utf(span<const InChar> in, span<OutChar> out, utfstate_t& state, flags<utf_conversion_options> options);
+        template <typename InChar>
+        std::pair<utf_result, std::string> utf_to_u8string(span<const InChar> in, flags<utf_conversion_options> options);
+        template <typename Char>
+        std::basic_string<Char> utf_case_fold(span<const Char> in);
+
+        size_t count_bits(unsigned value) noexcept;
+        size_t utf8_decode_sequence(const char* p, const char* end, char32_t& code) noexcept;
+        const char* utf8_resume_point(const char* first, const char* p) noexcept;
     }
 
     std::pair<utf_result, char32_t> to_utf32(char in, utfstate_t& state)
@@ -208,8 +250,1121 @@ namespace stdext
         return to_utf16(char32_t(state.code), state);
     }
 
+    utf_conversion_result to_utf16(span<const char> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf8_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf32(span<const char> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf8_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf8(span<const char> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf8(span<const char16_t> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf8(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf8(span<const char32_t> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf8(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf16(span<const char16_t> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf16(span<const char32_t> in, span<char16_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf32(span<const char16_t> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf(in, out, state, options);
+    }
+
+    utf_conversion_result to_utf32(span<const char32_t> in, span<char32_t> out, utfstate_t& state, flags<utf_conversion_options> options)
+    {
+        return utf_to_utf(in, out, state, options);
+    }
+
+    std::pair<utf_result, std::string> to_u8string(span<const char16_t> in, flags<utf_conversion_options> options)
+    {
+        return utf_to_u8string(in, options);
+    }
+
+    std::pair<utf_result, std::string> to_u8string(span<const char32_t> in, flags<utf_conversion_options> options)
+    {
+        return utf_to_u8string(in, options);
+    }
+
     namespace
     {
+#if STDEXT_UNICODE_SSSE3 || STDEXT_UNICODE_NEON
+        // Screens 16-byte blocks using the lookup table algorithm described by Keiser and Lemire
+        // in "Validating UTF-8 In Less Than One Instruction Per Byte".  Each pair of adjacent
+        // bytes is classified by three table lookups (the high and low nibbles of the first byte
+        // and the high nibble of the second), and the classes are intersected to find malformed
+        // pairs; third and fourth bytes of a sequence are checked separately.  Byte pairs that
+        // might end a noncharacter (EF B7 for U+FDD0-U+FDEF; BF BE and BF BF for U+xFFFE and
+        // U+xFFFF) are flagged as well, since the algorithm doesn't know about them.
+        class utf8_block_validator
+        {
+        private:
+            static constexpr uint8_t too_short = 1 << 0;       // 11______ 0_______ or 11______ 11______
+            static constexpr uint8_t too_long = 1 << 1;        // 0_______ 10______
+            static constexpr uint8_t overlong_3 = 1 << 2;      // 11100000 100_____
+            static constexpr uint8_t too_large = 1 << 3;       // 11110100 1001____ or 11110100 101_____ or 11110101+
+            static constexpr uint8_t surrogate = 1 << 4;       // 11101101 101_____
+            static constexpr uint8_t overlong_2 = 1 << 5;      // 1100000_ 10______
+            static constexpr uint8_t too_large_1000 = 1 << 6;  // 11110101+ 1000____
+            static constexpr uint8_t overlong_4 = 1 << 6;      // 11110000 1000____
+            static constexpr uint8_t two_conts = 1 << 7;       // 10______ 10______
+            static constexpr uint8_t carry = too_short | too_long | two_conts;
+
+            static constexpr uint8_t byte_1_high[16] =
+            {
+                too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+                two_conts, two_conts, two_conts, two_conts,
+                too_short | overlong_2,
+                too_short,
+                too_short | overlong_3 | surrogate,
+                too_short | too_large | too_large_1000 | overlong_4
+            };
+
+            static constexpr uint8_t byte_1_low[16] =
+            {
+                carry | overlong_3 | overlong_2 | overlong_4,
+                carry | overlong_2,
+                carry,
+                carry,
+                carry | too_large,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000 | surrogate,
+                carry | too_large | too_large_1000,
+                carry | too_large | too_large_1000
+            };
+
+            static constexpr uint8_t byte_2_high[16] =
+            {
+                too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+                too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+                too_long | overlong_2 | two_conts | overlong_3 | too_large,
+                too_long | overlong_2 | two_conts | surrogate | too_large,
+                too_long | overlong_2 | two_conts | surrogate | too_large,
+                too_short, too_short, too_short, too_short
+            };
+
+            // A lead byte in one of the last three positions whose sequence doesn't fit.
+            static constexpr uint8_t incomplete_limits[16] =
+            {
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+            };
+
+#if STDEXT_UNICODE_SSSE3
+        public:
+            // Returns true if the block at p might contain (or complete) an invalid sequence or a
+            // noncharacter.  Blocks must be presented in order, with no gaps.
+            bool suspect(const char* p) noexcept
+            {
+                auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                auto zero = _mm_setzero_si128();
+                if (_mm_movemask_epi8(input) == 0)
+                {
+                    auto incomplete = _mm_movemask_epi8(_mm_cmpeq_epi8(_prev_incomplete, zero)) != 0xFFFF;
+                    _prev = input;
+                    _prev_incomplete = zero;
+                    return incomplete;
+                }
+
+                auto low_nibble = _mm_set1_epi8(0x0F);
+                auto prev1 = _mm_alignr_epi8(input, _prev, 15);
+                auto special = _mm_and_si128(
+                    _mm_and_si128(
+                        _mm_shuffle_epi8(load(byte_1_high), _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble)),
+                        _mm_shuffle_epi8(load(byte_1_low), _mm_and_si128(prev1, low_nibble))),
+                    _mm_shuffle_epi8(load(byte_2_high), _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble)));
+
+                auto third = _mm_subs_epu8(_mm_alignr_epi8(input, _prev, 14), _mm_set1_epi8(char(0xE0 - 0x80)));
+                auto fourth = _mm_subs_epu8(_mm_alignr_epi8(input, _prev, 13), _mm_set1_epi8(char(0xF0 - 0x80)));
+                auto must_be_continuation = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+                auto error = _mm_xor_si128(must_be_continuation, special);
+
+                auto noncharacter = _mm_or_si128(
+                    _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(char(0xEF))), _mm_cmpeq_epi8(input, _mm_set1_epi8(char(0xB7)))),
+                    _mm_and_si128(_mm_cmpeq_epi8(prev1, _mm_set1_epi8(char(0xBF))), _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(char(0xBE))), input)));
+                error = _mm_or_si128(error, noncharacter);
+
+                _prev = input;
+                _prev_incomplete = _mm_subs_epu8(input, load(incomplete_limits));
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF;
+            }
+
+            // Forgets the previous block; the next block must begin a sequence.
+            void reset() noexcept
+            {
+                _prev = _mm_setzero_si128();
+                _prev_incomplete = _mm_setzero_si128();
+            }
+
+        private:
+            static __m128i load(const uint8_t (&table)[16]) noexcept
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+            }
+
+        private:
+            __m128i _prev = _mm_setzero_si128();
+            __m128i _prev_incomplete = _mm_setzero_si128();
+#else
+        public:
+            // Returns true if the block at p might contain (or complete) an invalid sequence or a
+            // noncharacter.  Blocks must be presented in order, with no gaps.
+            bool suspect(const char* p) noexcept
+            {
+                auto input = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+                if (vmaxvq_u8(input) < 0x80)
+                {
+                    auto incomplete = vmaxvq_u8(_prev_incomplete) != 0;
+                    _prev = input;
+                    _prev_incomplete = vdupq_n_u8(0);
+                    return incomplete;
+                }
+
+                auto low_nibble = vdupq_n_u8(0x0F);
+                auto prev1 = vextq_u8(_prev, input, 15);
+                auto special = vandq_u8(
+                    vandq_u8(
+                        vqtbl1q_u8(vld1q_u8(byte_1_high), vshrq_n_u8(prev1, 4)),
+                        vqtbl1q_u8(vld1q_u8(byte_1_low), vandq_u8(prev1, low_nibble))),
+                    vqtbl1q_u8(vld1q_u8(byte_2_high), vshrq_n_u8(input, 4)));
+
+                auto third = vqsubq_u8(vextq_u8(_prev, input, 14), vdupq_n_u8(0xE0 - 0x80));
+                auto fourth = vqsubq_u8(vextq_u8(_prev, input, 13), vdupq_n_u8(0xF0 - 0x80));
+                auto must_be_continuation = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+                auto error = veorq_u8(must_be_continuation, special);
+
+                auto noncharacter = vorrq_u8(
+                    vandq_u8(vceqq_u8(prev1, vdupq_n_u8(0xEF)), vceqq_u8(input, vdupq_n_u8(0xB7))),
+                    vandq_u8(vceqq_u8(prev1, vdupq_n_u8(0xBF)), vcgeq_u8(input, vdupq_n_u8(0xBE))));
+                error = vorrq_u8(error, noncharacter);
+
+                _prev = input;
+                _prev_incomplete = vqsubq_u8(input, vld1q_u8(incomplete_limits));
+                return vmaxvq_u8(error) != 0;
+            }
+
+            // Forgets the previous block; the next block must begin a sequence.
+            void reset() noexcept
+            {
+                _prev = vdupq_n_u8(0);
+                _prev_incomplete = vdupq_n_u8(0);
+            }
+
+        private:
+            uint8x16_t _prev = vdupq_n_u8(0);
+            uint8x16_t _prev_incomplete = vdupq_n_u8(0);
+#endif
+        };
+#elif STDEXT_UNICODE_SSE2
+        // Without a byte shuffle, only pure ASCII blocks are screened out.
+        class utf8_block_validator
+        {
+        public:
+            bool suspect(const char* p) noexcept
+            {
+                return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) != 0;
+            }
+
+            void reset() noexcept { }
+        };
+#else
+        class utf8_block_validator
+        {
+        public:
+            bool suspect(const char* p) noexcept
+            {
+                uint64_t v[2];
+                std::memcpy(v, p, sizeof(v));
+                return ((v[0] | v[1]) & 0x80808080'80808080) != 0;
+            }
+
+            void reset() noexcept { }
+        };
+#endif
+    }
+
+    size_t utf8_validate(span<const char> in) noexcept
+    {
+        auto first = in.data();
+        auto last = first + in.size();
+        auto p = first;
+
+        utf8_block_validator validator;
+        while (last - p >= 16)
+        {
+            if (!validator.suspect(p))
+            {
+                p += 16;
+                continue;
+            }
+
+            // Pin down the problem (if there is one) by decoding through the end of the block.
+            auto block_end = p + 16;
+            for (p = utf8_resume_point(first, p); p < block_end; )
+            {
+                char32_t code;
+                auto length = utf8_decode_sequence(p, last, code);
+                if (length == 0)
+                    return size_t(p - first);
+                p += length;
+            }
+
+            validator.reset();
+        }
+
+        for (p = utf8_resume_point(first, p); p != last; )
+        {
+            char32_t code;
+            auto length = utf8_decode_sequence(p, last, code);
+            if (length == 0)
+                return size_t(p - first);
+            p += length;
+        }
+
+        return in.size();
+    }
+
+    namespace
+    {
+        template <typename Char, typename Function>
+        size_t sum_units(const Char* p, size_t size, Function f) noexcept
+        {
+            size_t sum = 0;
+            for (size_t n = 0; n != size; ++n)
+                sum += size_t(f(p[n]));
+            return sum;
+        }
+    }
+
+    size_t utf8_count_code_points(span<const char> in) noexcept
+    {
+        auto p = in.data();
+        auto size = in.size();
+        size_t n = 0, continuations = 0;
+
+#if STDEXT_UNICODE_SSE2
+        for (; size - n >= 16; n += 16)
+        {
+            // Continuation bytes are the signed values below -64.
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+            continuations += count_bits(_mm_movemask_epi8(_mm_cmplt_epi8(v, _mm_set1_epi8(-64))));
+        }
+#elif STDEXT_UNICODE_NEON
+        for (; size - n >= 16; n += 16)
+        {
+            auto v = vld1q_s8(reinterpret_cast<const int8_t*>(p + n));
+            continuations += vaddvq_u8(vshrq_n_u8(vcltq_s8(v, vdupq_n_s8(-64)), 7));
+        }
+#endif
+
+        continuations += sum_units(p + n, size - n, [](char c) { return utf8_is_trailing(c); });
+        return size - continuations;
+    }
+
+    size_t utf16_length_from_utf8(span<const char> in) noexcept
+    {
+        // One code unit per code point, plus one for each four-byte sequence.
+        auto p = in.data();
+        auto size = in.size();
+        size_t n = 0, four_byte_leads = 0;
+
+#if STDEXT_UNICODE_SSE2
+        for (; size - n >= 16; n += 16)
+        {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+            auto mask = _mm_set1_epi8(char(0xF0));
+            four_byte_leads += count_bits(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, mask), mask)));
+        }
+#elif STDEXT_UNICODE_NEON
+        for (; size - n >= 16; n += 16)
+        {
+            auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + n));
+            four_byte_leads += vaddvq_u8(vshrq_n_u8(vcgeq_u8(v, vdupq_n_u8(0xF0)), 7));
+        }
+#endif
+
+        four_byte_leads += sum_units(p + n, size - n, [](char c) { return uint8_t(c) >= 0xF0; });
+        return utf8_count_code_points(in) + four_byte_leads;
+    }
+
+    size_t utf8_length_from_utf16(span<const char16_t> in) noexcept
+    {
+        // Three bytes per code unit, less one for each unit below 0x800 and another for each unit
+        // below 0x80.  Surrogates take two bytes apiece, for four per pair.
+        auto p = in.data();
+        auto size = in.size();
+        size_t n = 0, savings = 0;
+
+#if STDEXT_UNICODE_SSE2
+        auto zero = _mm_setzero_si128();
+        for (; size - n >= 8; n += 8)
+        {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+            auto high_bits = _mm_and_si128(v, _mm_set1_epi16(short(0xF800)));
+            auto ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(~0x7F)), zero);
+            auto small = _mm_cmpeq_epi16(high_bits, zero);
+            auto surrogate = _mm_cmpeq_epi16(high_bits, _mm_set1_epi16(short(0xD800)));
+            savings += (count_bits(_mm_movemask_epi8(ascii)) + count_bits(_mm_movemask_epi8(_mm_or_si128(small, surrogate)))) / 2;
+        }
+#elif STDEXT_UNICODE_NEON
+        for (; size - n >= 8; n += 8)
+        {
+            auto v = vld1q_u16(reinterpret_cast<const uint16_t*>(p + n));
+            auto high_bits = vandq_u16(v, vdupq_n_u16(0xF800));
+            auto ascii = vshrq_n_u16(vcltq_u16(v, vdupq_n_u16(0x80)), 15);
+            auto small = vshrq_n_u16(vorrq_u16(vceqq_u16(high_bits, vdupq_n_u16(0)), vceqq_u16(high_bits, vdupq_n_u16(0xD800))), 15);
+            savings += vaddvq_u16(vaddq_u16(ascii, small));
+        }
+#endif
+
+        savings += sum_units(p + n, size - n, [](char16_t c) { return (c < 0x80 ? 1 : 0) + (c < 0x800 || is_surrogate(c) ? 1 : 0); });
+        return 3 * size - savings;
+    }
+
+    std::string case_fold(span<const char> in)
+    {
+        return utf_case_fold(in);
+    }
+
+    std::u16string case_fold(span<const char16_t> in)
+    {
+        return utf_case_fold(in);
+    }
+
+    std::u32string case_fold(span<const char32_t> in)
+    {
+        return utf_case_fold(in);
+    }
+
+    namespace
+    {
+        size_t count_bits(unsigned value) noexcept
+        {
+            return std::bitset<32>(value).count();
+        }
+
+        // Copies the run of ASCII characters at the start of in to out, widening each one, and
+        // returns the length of the run.  Stops early if out fills up.
+        template <typename OutChar>
+        size_t widen_ascii(const char* in, size_t in_size, OutChar* out, size_t out_size) noexcept
+        {
+            auto size = std::min(in_size, out_size);
+            size_t n = 0;
+
+#if STDEXT_UNICODE_SSE2
+            auto zero = _mm_setzero_si128();
+            for (; size - n >= 16; n += 16)
+            {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n));
+                if (_mm_movemask_epi8(v) != 0)
+                    break;
+
+                auto lo = _mm_unpacklo_epi8(v, zero);
+                auto hi = _mm_unpackhi_epi8(v, zero);
+                if constexpr (sizeof(OutChar) == 2)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), lo);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 8), hi);
+                }
+                else
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm_unpacklo_epi16(lo, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 4), _mm_unpackhi_epi16(lo, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 8), _mm_unpacklo_epi16(hi, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 12), _mm_unpackhi_epi16(hi, zero));
+                }
+            }
+#elif STDEXT_UNICODE_NEON
+            for (; size - n >= 16; n += 16)
+            {
+                auto v = vld1q_u8(reinterpret_cast<const uint8_t*>(in + n));
+                if (vmaxvq_u8(v) >= 0x80)
+                    break;
+
+                auto lo = vmovl_u8(vget_low_u8(v));
+                auto hi = vmovl_u8(vget_high_u8(v));
+                if constexpr (sizeof(OutChar) == 2)
+                {
+                    vst1q_u16(reinterpret_cast<uint16_t*>(out + n), lo);
+                    vst1q_u16(reinterpret_cast<uint16_t*>(out + n + 8), hi);
+                }
+                else
+                {
+                    vst1q_u32(reinterpret_cast<uint32_t*>(out + n), vmovl_u16(vget_low_u16(lo)));
+                    vst1q_u32(reinterpret_cast<uint32_t*>(out + n + 4), vmovl_u16(vget_high_u16(lo)));
+                    vst1q_u32(reinterpret_cast<uint32_t*>(out + n + 8), vmovl_u16(vget_low_u16(hi)));
+                    vst1q_u32(reinterpret_cast<uint32_t*>(out + n + 12), vmovl_u16(vget_high_u16(hi)));
+                }
+            }
+#else
+            for (; size - n >= 8; n += 8)
+            {
+                uint64_t v;
+                std::memcpy(&v, in + n, sizeof(v));
+                if ((v & 0x80808080'80808080) != 0)
+                    break;
+
+                for (size_t i = 0; i != 8; ++i)
+                    out[n + i] = OutChar(in[n + i]);
+            }
+#endif
+
+            for (; n != size && uint8_t(in[n]) < 0x80; ++n)
+                out[n] = OutChar(in[n]);
+
+            return n;
+        }
+
+        // Decodes the UTF-8 sequence at the start of [p, end), returning its length, or zero if
+        // the sequence is incomplete or would be rejected by to_utf32(char, utfstate_t&).
+        size_t utf8_decode_sequence(const char* p, const char* end, char32_t& code) noexcept
+        {
+            auto b0 = uint8_t(p[0]);
+            if (b0 < 0x80)
+            {
+                code = b0;
+                return 1;
+            }
+
+            auto length = utf8_character_length(p[0]);
+            if (length == 0 || size_t(end - p) < length)
+                return 0;
+
+            for (size_t n = 1; n != length; ++n)
+            {
+                if (!utf8_is_trailing(p[n]))
+                    return 0;
+            }
+
+            auto b1 = uint8_t(p[1]);
+            switch (length)
+            {
+            case 2:
+                code = char32_t(b0 & 0x1F) << 6 | (b1 & 0x3F);
+                break;
+
+            case 3:
+                if ((b0 == 0xE0 && b1 < 0xA0) || (b0 == 0xED && b1 >= 0xA0))
+                    return 0;
+                code = char32_t(b0 & 0x0F) << 12 | char32_t(b1 & 0x3F) << 6 | (p[2] & 0x3F);
+                break;
+
+            case 4:
+                if ((b0 == 0xF0 && b1 < 0x90) || (b0 == 0xF4 && b1 >= 0x90))
+                    return 0;
+                code = char32_t(b0 & 0x07) << 18 | char32_t(b1 & 0x3F) << 12 | char32_t(p[2] & 0x3F) << 6 | (p[3] & 0x3F);
+                break;
+            }
+
+            if (is_noncharacter(code))
+                return 0;
+
+            return length;
+        }
+
+        // Given a position p reached by skipping over blocks of valid input, returns the position
+        // from which to resume decoding: the start of a sequence that begins in the three bytes
+        // before p and may not have been completed, or p itself.
+        const char* utf8_resume_point(const char* first, const char* p) noexcept
+        {
+            for (auto q = p; q != first && p - q < 3; )
+            {
+                auto c = uint8_t(*--q);
+                if (!utf8_is_trailing(char(c)))
+                    return c >= 0xC0 ? q : p;
+            }
+
+            return p;
+        }
+
+        // Converts a single code point one code unit at a time using the code unit functions, so
+        // that errors, sanitization, and partial sequences are handled exactly as they are there.
+        // Nothing is committed to p, q, or state unless the code point's output fits.
+        template <typename InChar, typename OutChar>
+        utf_result convert_one(const InChar*& p, const InChar* in_end, OutChar*& q, OutChar* out_end, utfstate_t& state, flags<utf_conversion_options> options)
+        {
+            auto s = state;
+            auto r = p;
+            OutChar units[4];
+            size_t count = 0;
+
+            for (;;)
+            {
+                auto [result, code] = _private::to_utf<OutChar>(*r, s);
+                if (result == utf_result::error)
+                {
+                    if (!options.test_any(utf_conversion_options::sanitize))
+                    {
+                        p = r;
+                        state = s;
+                        return utf_result::error;
+                    }
+
+                    if (s.consumed == 0)
+                        ++r;
+
+                    s = { };
+                    do
+                        std::tie(result, units[count++]) = _private::to_utf<OutChar>(UNICODE_REPLACEMENT_CHARACTER, s);
+                    while (result == utf_result::partial_write);
+                    break;
+                }
+
+                if (result == utf_result::partial_read)
+                {
+                    if (++r == in_end)
+                    {
+                        p = r;
+                        state = s;
+                        return utf_result::ok;
+                    }
+                    continue;
+                }
+
+                units[count++] = code;
+                if (result == utf_result::ok)
+                {
+                    ++r;
+                    break;
+                }
+            }
+
+            if (size_t(out_end - q) < count)
+                return utf_result::partial_write;
+
+            q = std::copy_n(units, count, q);
+            p = r;
+            state = s;
+            return utf_result::ok;
+        }
+
+        template <typename OutChar>
+        utf_conversion_result utf8_to_utf(span<const char> in, span<OutChar> out, utfstate_t& state, flags<utf_conversion_options> options)
+        {
+            auto p = in.data();
+            auto in_end = p + in.size();
+            auto q = out.data();
+            auto out_end = q + out.size();
+            auto finish = [&](utf_result result)
+            {
+                return utf_conversion_result{ result, size_t(p - in.data()), size_t(q - out.data()) };
+            };
+
+            while (p != in_end)
+            {
+                if (state.consumed == 0)
+                {
+                    auto count = widen_ascii(p, size_t(in_end - p), q, size_t(out_end - q));
+                    p += count;
+                    q += count;
+                    if (p == in_end)
+                        break;
+
+                    char32_t code;
+                    if (auto length = utf8_decode_sequence(p, in_end, code))
+                    {
+                        auto units = sizeof(OutChar) == sizeof(char16_t) && code >= 0x10000 ? 2 : 1;
+                        if (out_end - q < units)
+                            return finish(utf_result::partial_write);
+
+                        if (units == 2)
+                        {
+                            *q++ = OutChar(0xD800 | (code - 0x10000) >> 10);
+                            *q++ = OutChar(0xDC00 | (code & 0x03FF));
+                        }
+                        else
+                            *q++ = OutChar(code);
+
+                        p += length;
+                        continue;
+                    }
+                }
+
+                // A sequence continued from a previous call, an invalid sequence, or one cut off by
+                // the end of the input.
+                auto result = convert_one(p, in_end, q, out_end, state, options);
+                if (result != utf_result::ok)
+                    return finish(result);
+            }
+
+            return finish(state.consumed != 0 ? utf_result::partial_read : utf_result::ok);
+        }
+
+        // Copies the run of ASCII characters at the start of in to out, narrowing each one, and
+        // returns the length of the run.  Stops early if out fills up.
+        template <typename InChar>
+        size_t narrow_ascii(const InChar* in, size_t in_size, char* out, size_t out_size) noexcept
+        {
+            auto size = std::min(in_size, out_size);
+            size_t n = 0;
+
+#if STDEXT_UNICODE_SSE2
+            for (; size - n >= 8; n += 8)
+            {
+                __m128i v;
+                if constexpr (sizeof(InChar) == 2)
+                    v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n));
+                else
+                {
+                    auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n));
+                    auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n + 4));
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(lo, hi), _mm_set1_epi32(~0x7F)), _mm_setzero_si128())) != 0xFFFF)
+                        break;
+                    v = _mm_packs_epi32(lo, hi);
+                }
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(~0x7F)), _mm_setzero_si128())) != 0xFFFF)
+                    break;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + n), _mm_packus_epi16(v, v));
+            }
+#elif STDEXT_UNICODE_NEON
+            for (; size - n >= 8; n += 8)
+            {
+                uint16x8_t v;
+                if constexpr (sizeof(InChar) == 2)
+                    v = vld1q_u16(reinterpret_cast<const uint16_t*>(in + n));
+                else
+                {
+                    auto lo = vld1q_u32(reinterpret_cast<const uint32_t*>(in + n));
+                    auto hi = vld1q_u32(reinterpret_cast<const uint32_t*>(in + n + 4));
+                    if (vmaxvq_u32(vorrq_u32(lo, hi)) >= 0x80)
+                        break;
+                    v = vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+                }
+
+                if (vmaxvq_u16(v) >= 0x80)
+                    break;
+                vst1_u8(reinterpret_cast<uint8_t*>(out + n), vmovn_u16(v));
+            }
+#endif
+
+            for (; n != size && in[n] < 0x80; ++n)
+                out[n] = char(in[n]);
+
+            return n;
+        }
+
+        constexpr size_t no_length = size_t(-1);
+
+        // Returns the UTF-8 length of a block of eight UTF-16 or UTF-32 code units, or no_length if
+        // the block contains anything that needs a closer look: surrogates, noncharacters, or (for
+        // UTF-32) values outside the code space.
+        template <typename InChar>
+        size_t block_utf8_length(const InChar* p) noexcept
+        {
+#if STDEXT_UNICODE_SSE2
+            auto zero = _mm_setzero_si128();
+            if constexpr (sizeof(InChar) == 2)
+            {
+                auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                auto high_bits = _mm_and_si128(v, _mm_set1_epi16(short(0xF800)));
+                auto special = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_cmpeq_epi16(high_bits, _mm_set1_epi16(short(0xD800))),
+                        _mm_cmpeq_epi16(_mm_and_si128(_mm_sub_epi16(v, _mm_set1_epi16(short(0xFDD0))), _mm_set1_epi16(short(0xFFE0))), zero)),
+                    _mm_cmpeq_epi16(_mm_or_si128(v, _mm_set1_epi16(1)), _mm_set1_epi16(-1)));
+                if (_mm_movemask_epi8(special) != 0)
+                    return no_length;
+
+                // Each unit takes three bytes, less one if it's below 0x800 and another if it's
+                // below 0x80.
+                auto ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(~0x7F)), zero));
+                auto small = _mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero));
+                return 3 * 8 - (count_bits(ascii) + count_bits(small)) / 2;
+            }
+            else
+            {
+                size_t length = 0;
+                for (size_t n = 0; n != 8; n += 4)
+                {
+                    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+                    auto special = _mm_or_si128(
+                        _mm_or_si128(
+                            _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(~0x07FF)), _mm_set1_epi32(0xD800)),
+                            _mm_cmpeq_epi32(_mm_and_si128(_mm_sub_epi32(v, _mm_set1_epi32(0xFDD0)), _mm_set1_epi32(~0x1F)), zero)),
+                        _mm_or_si128(
+                            _mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(v, _mm_set1_epi32(1)), _mm_set1_epi32(0xFFFF)), _mm_set1_epi32(0xFFFF)),
+                            _mm_cmpgt_epi32(_mm_srli_epi32(v, 16), _mm_set1_epi32(0x10))));
+                    if (_mm_movemask_epi8(special) != 0)
+                        return no_length;
+
+                    // Each unit takes four bytes, less one for each of 0x10000, 0x800, and 0x80
+                    // that it falls below.
+                    auto below = [&](int32_t mask)
+                    {
+                        return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(mask)), zero));
+                    };
+                    length += 4 * 4 - (count_bits(below(~0xFFFF)) + count_bits(below(~0x07FF)) + count_bits(below(~0x7F))) / 4;
+                }
+                return length;
+            }
+#elif STDEXT_UNICODE_NEON
+            if constexpr (sizeof(InChar) == 2)
+            {
+                auto v = vld1q_u16(reinterpret_cast<const uint16_t*>(p));
+                auto high_bits = vandq_u16(v, vdupq_n_u16(0xF800));
+                auto special = vorrq_u16(
+                    vorrq_u16(
+                        vceqq_u16(high_bits, vdupq_n_u16(0xD800)),
+                        vcltq_u16(vsubq_u16(v, vdupq_n_u16(0xFDD0)), vdupq_n_u16(0x20))),
+                    vcgeq_u16(v, vdupq_n_u16(0xFFFE)));
+                if (vmaxvq_u16(special) != 0)
+                    return no_length;
+
+                auto three = vdupq_n_u16(3);
+                auto lengths = vsubq_u16(
+                    vsubq_u16(three, vshrq_n_u16(vceqq_u16(high_bits, vdupq_n_u16(0)), 15)),
+                    vshrq_n_u16(vcltq_u16(v, vdupq_n_u16(0x80)), 15));
+                return vaddvq_u16(lengths);
+            }
+            else
+            {
+                size_t length = 0;
+                for (size_t n = 0; n != 8; n += 4)
+                {
+                    auto v = vld1q_u32(reinterpret_cast<const uint32_t*>(p + n));
+                    auto special = vorrq_u32(
+                        vorrq_u32(
+                            vceqq_u32(vandq_u32(v, vdupq_n_u32(~0x07FFu)), vdupq_n_u32(0xD800)),
+                            vcltq_u32(vsubq_u32(v, vdupq_n_u32(0xFDD0)), vdupq_n_u32(0x20))),
+                        vorrq_u32(
+                            vcgeq_u32(vandq_u32(v, vdupq_n_u32(0xFFFF)), vdupq_n_u32(0xFFFE)),
+                            vcgtq_u32(v, vdupq_n_u32(0x10FFFF))));
+                    if (vmaxvq_u32(special) != 0)
+                        return no_length;
+
+                    auto lengths = vsubq_u32(
+                        vsubq_u32(
+                            vsubq_u32(vdupq_n_u32(4), vshrq_n_u32(vcltq_u32(v, vdupq_n_u32(0x10000)), 31)),
+                            vshrq_n_u32(vcltq_u32(v, vdupq_n_u32(0x800)), 31)),
+                        vshrq_n_u32(vcltq_u32(v, vdupq_n_u32(0x80)), 31));
+                    length += vaddvq_u32(lengths);
+                }
+                return length;
+            }
+#else
+            size_t length = 0;
+            for (size_t n = 0; n != 8; ++n)
+            {
+                char32_t code = p[n];
+                if constexpr (sizeof(InChar) == 2)
+                {
+                    if (is_surrogate(char16_t(code)))
+                        return no_length;
+                }
+                if (!utf32_is_valid(code))
+                    return no_length;
+
+                length += code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+            }
+            return length;
+#endif
+        }
+
+        // Decodes the code point at the start of [p, end), returning the number of code units it
+        // occupies, or zero if it's incomplete or would be rejected by the code unit functions.
+        size_t utf_decode_sequence(const char16_t* p, const char16_t* end, char32_t& code) noexcept
+        {
+            if (!is_surrogate(p[0]))
+            {
+                code = p[0];
+                return is_noncharacter(code) ? 0 : 1;
+            }
+
+            if (is_trailing_surrogate(p[0]) || end - p < 2 || !is_trailing_surrogate(p[1]))
+                return 0;
+
+            code = 0x10000 + (char32_t(p[0] & 0x03FF) << 10 | (p[1] & 0x03FF));
+            return is_noncharacter(code) ? 0 : 2;
+        }
+
+        size_t utf_decode_sequence(const char32_t* p, const char32_t*, char32_t& code) noexcept
+        {
+            code = p[0];
+            return utf32_is_valid(code) ? 1 : 0;
+        }
+
+        char* utf8_encode(char32_t code, char* out) noexcept
+        {
+            if (code < 0x80)
+                *out++ = char(code);
+            else if (code < 0x800)
+            {
+                *out++ = char(0xC0 | code >> 6);
+                *out++ = char(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                *out++ = char(0xE0 | code >> 12);
+                *out++ = char(0x80 | (code >> 6 & 0x3F));
+                *out++ = char(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                *out++ = char(0xF0 | code >> 18);
+                *out++ = char(0x80 | (code >> 12 & 0x3F));
+                *out++ = char(0x80 | (code >> 6 & 0x3F));
+                *out++ = char(0x80 | (code & 0x3F));
+            }
+            return out;
+        }
+
+        constexpr size_t utf8_encoded_length(char32_t code) noexcept
+        {
+            return code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+        }
+
+        size_t utf_decode_sequence(const char* p, const char* end, char32_t& code) noexcept
+        {
+            return utf8_decode_sequence(p, end, code);
+        }
+
+        char* utf_encode(char32_t code, char* out) noexcept
+        {
+            return utf8_encode(code, out);
+        }
+
+        char16_t* utf_encode(char32_t code, char16_t* out) noexcept
+        {
+            if (code < 0x10000)
+                *out++ = char16_t(code);
+            else
+            {
+                *out++ = char16_t(0xD800 | (code - 0x10000) >> 10);
+                *out++ = char16_t(0xDC00 | (code & 0x03FF));
+            }
+            return out;
+        }
+
+        char32_t* utf_encode(char32_t code, char32_t* out) noexcept
+        {
+            *out++ = code;
+            return out;
+        }
+
+        template <typename OutChar>
+        constexpr size_t utf_encoded_length(char32_t code) noexcept
+        {
+            if constexpr (std::is_same_v<OutChar, char>)
+                return utf8_encoded_length(code);
+            else if constexpr (std::is_same_v<OutChar, char16_t>)
+                return code < 0x10000 ? 1 : 2;
+            else
+                return 1;
+        }
+
+        template <typename Char>
+        std::basic_string<Char> utf_case_fold(span<const Char> in)
+        {
+            std::basic_string<Char> out;
+            out.reserve(in.size());
+
+            auto p = in.data();
+            auto end = p + in.size();
+            auto is_ascii = [](Char c) { return std::make_unsigned_t<Char>(c) < 0x80; };
+
+            utf_transcoder<Char, char32_t> decoder(utf_conversion_options::sanitize);
+            char32_t buffer[0x100];
+            auto fold = [&](size_t count)
+            {
+                for (size_t n = 0; n != count; ++n)
+                {
+                    Char units[4];
+                    out.append(units, utf_encode(case_fold(buffer[n]), units));
+                }
+            };
+
+            while (p != end)
+            {
+                // ASCII characters never take part in a longer sequence, so runs of them can be
+                // folded without decoding.
+                auto ascii_end = std::find_if_not(p, end, is_ascii);
+                if constexpr (std::is_same_v<Char, char>)
+                {
+                    auto size = out.size();
+                    out.resize(size + size_t(ascii_end - p));
+                    ascii_to_lower(string_view(p, ascii_end), out.data() + size);
+                }
+                else
+                {
+                    for (; p != ascii_end; ++p)
+                        out.push_back(char32_t(*p) - U'A' < 26 ? Char(*p + 0x20) : *p);
+                }
+                p = ascii_end;
+
+                auto run_end = std::find_if(p, end, is_ascii);
+                auto run = span<const Char>(p, size_t(run_end - p));
+                while (!run.empty())
+                {
+                    auto result = decoder.convert(run, span<char32_t>(buffer));
+                    fold(result.written);
+                    run = run.subspan(result.read);
+                }
+                fold(decoder.finish(span<char32_t>(buffer)).written);
+                p = run_end;
+            }
+
+            return out;
+        }
+
+        // The general case, for conversions without a more specialized implementation.
+        template <typename InChar, typename OutChar>
+        utf_conversion_result utf_to_utf(span<const InChar> in, span<OutChar> out, utfstate_t& state, flags<utf_conversion_options> options)
+        {
+            auto p = in.data();
+            auto in_end = p + in.size();
+            auto q = out.data();
+            auto out_end = q + out.size();
+            auto finish = [&](utf_result result)
+            {
+                return utf_conversion_result{ result, size_t(p - in.data()), size_t(q - out.data()) };
+            };
+
+            while (p != in_end)
+            {
+                if (state.consumed == 0)
+                {
+                    char32_t code;
+                    if (auto units = utf_decode_sequence(p, in_end, code))
+                    {
+                        if (size_t(out_end - q) < utf_encoded_length<OutChar>(code))
+                            return finish(utf_result::partial_write);
+
+                        q = utf_encode(code, q);
+                        p += units;
+                        continue;
+                    }
+                }
+
+                auto result = convert_one(p, in_end, q, out_end, state, options);
+                if (result != utf_result::ok)
+                    return finish(result);
+            }
+
+            return finish(state.consumed != 0 ? utf_result::partial_read : utf_result::ok);
+        }
+
+        // Computes the exact length of the output of utf_to_utf8 for the same input, given an
+        // empty initial state.
+        template <typename InChar>
+        std::pair<utf_result, size_t> utf8_length(span<const InChar> in, flags<utf_conversion_options> options)
+        {
+            auto p = in.data();
+            auto end = p + in.size();
+            size_t length = 0;
+            utfstate_t state = { };
+
+            while (p != end)
+            {
+                if (end - p >= 8)
+                {
+                    auto block_length = block_utf8_length(p);
+                    if (block_length != no_length)
+                    {
+                        length += block_length;
+                        p += 8;
+                        continue;
+                    }
+                }
+
+                char32_t code;
+                if (auto units = utf_decode_sequence(p, end, code))
+                {
+                    length += utf8_encoded_length(code);
+                    p += units;
+                    continue;
+                }
+
+                char buffer[4];
+                auto q = buffer;
+                if (convert_one(p, end, q, std::end(buffer), state, options) == utf_result::error)
+                    return { utf_result::error, length };
+                length += size_t(q - buffer);
+            }
+
+            return { state.consumed != 0 ? utf_result::partial_read : utf_result::ok, length };
+        }
+
+        template <typename InChar>
+        utf_conversion_result utf_to_utf8(span<const InChar> in, span<char> out, utfstate_t& state, flags<utf_conversion_options> options)
+        {
+            auto p = in.data();
+            auto in_end = p + in.size();
+            auto q = out.data();
+            auto out_end = q + out.size();
+            auto finish = [&](utf_result result)
+            {
+                return utf_conversion_result{ result, size_t(p - in.data()), size_t(q - out.data()) };
+            };
+
+            while (p != in_end)
+            {
+                if (state.consumed == 0)
+                {
+                    auto count = narrow_ascii(p, size_t(in_end - p), q, size_t(out_end - q));
+                    p += count;
+                    q += count;
+                    if (p == in_end)
+                        break;
+
+                    char32_t code;
+                    if (auto units = utf_decode_sequence(p, in_end, code))
+                    {
+                        if (size_t(out_end - q) < utf8_encoded_length(code))
+                            return finish(utf_result::partial_write);
+
+                        q = utf8_encode(code, q);
+                        p += units;
+                        continue;
+                    }
+                }
+
+                auto result = convert_one(p, in_end, q, out_end, state, options);
+                if (result != utf_result::ok)
+                    return finish(result);
+            }
+
+            return finish(state.consumed != 0 ? utf_result::partial_read : utf_result::ok);
+        }
+
+        template <typename InChar>
+        std::pair<utf_result, std::string> utf_to_u8string(span<const InChar> in, flags<utf_conversion_options> options)
+        {
+            auto [result, length] = utf8_length(in, options);
+            std::string str(length, char());
+            utfstate_t state = { };
+            auto conversion = utf_to_utf8(in, span<char>(str), state, options);
+            assert(conversion.result == result && conversion.written == length);
+            stdext::discard(conversion);
+            return { result, stdext::move(str) };
+        }
+
         bool utf8_decode_first(uint8_t code, utfstate_t& state)
         {
             if ((code & 0x80) == 0x00)
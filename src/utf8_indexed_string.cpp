@@ -0,0 +1,84 @@
+#include <stdext/utf8_indexed_string.h>
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace stdext
+{
+    utf8_indexed_string::utf8_indexed_string(std::string str)
+    {
+        assign(stdext::move(str));
+    }
+
+    utf8_indexed_string::utf8_indexed_string(string_view str)
+        : utf8_indexed_string(std::string(str.data(), str.size()))
+    {
+    }
+
+    void utf8_indexed_string::assign(std::string str)
+    {
+        if (utf8_validate(str) != str.size())
+        {
+            // Each invalid byte becomes a three-byte replacement character, at worst.
+            std::string sanitized(str.size() * 3, char());
+            utf_transcoder<char, char> transcoder(utf_conversion_options::sanitize);
+            auto result = transcoder.convert(str, sanitized);
+            auto size = result.written;
+            size += transcoder.finish(span<char>(sanitized).subspan(size)).written;
+            sanitized.resize(size);
+            str = stdext::move(sanitized);
+        }
+
+        _str = stdext::move(str);
+        build_index();
+    }
+
+    utf8_indexed_string::const_iterator utf8_indexed_string::nth(size_t n) const noexcept
+    {
+        assert(n <= _size);
+        if (n == _size)
+            return end();
+
+        const_iterator i(_str.data() + _index[n / index_interval]);
+        for (n %= index_interval; n != 0; --n)
+            ++i;
+        return i;
+    }
+
+    size_t utf8_indexed_string::code_point_at(size_t offset) const noexcept
+    {
+        assert(offset <= _str.size());
+        if (offset == _str.size())
+            return _size;
+
+        auto k = size_t(std::upper_bound(_index.begin(), _index.end(), offset) - _index.begin()) - 1;
+        auto n = k * index_interval;
+        auto target = _str.data() + offset;
+        for (const_iterator i(_str.data() + _index[k]); (++i).base() <= target; )
+            ++n;
+        return n;
+    }
+
+    string_view utf8_indexed_string::substr(size_t pos, size_t count) const noexcept
+    {
+        pos = std::min(pos, _size);
+        auto first = nth(pos);
+        auto last = count >= _size - pos ? end() : nth(pos + count);
+        return string_view(first.base(), last.base());
+    }
+
+    void utf8_indexed_string::build_index()
+    {
+        _index.clear();
+        _size = 0;
+
+        auto first = _str.data();
+        auto last = first + _str.size();
+        for (auto p = first; p != last; p += utf8_character_length(*p))
+        {
+            if (_size++ % index_interval == 0)
+                _index.push_back(size_t(p - first));
+        }
+    }
+}
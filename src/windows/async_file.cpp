@@ -0,0 +1,404 @@
+#include <stdext/async_file.h>
+#include <stdext/scope_guard.h>
+#include <stdext/unicode.h>
+
+#include "open_flags.h"
+#include "platform.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        struct async_request
+        {
+            async_request(bool write, stream_position position, byte* buffer, size_t size, async_completion completion)
+                : write(write), position(position), buffer(buffer), size(size), completion(stdext::move(completion))
+            {
+            }
+
+            bool write;
+            stream_position position;
+            byte* buffer;
+            size_t size;
+            async_completion completion;
+
+            std::error_code error;
+            size_t transferred = 0;
+        };
+
+        class async_engine
+        {
+        public:
+            virtual ~async_engine() = default;
+
+        public:
+            virtual async_file_backend backend() const noexcept = 0;
+
+            void enqueue(std::unique_ptr<async_request> request)
+            {
+                _queued.push_back(stdext::move(request));
+                ++_pending;
+            }
+
+            size_t pending() const noexcept { return _pending; }
+
+            // Hands as many queued requests as possible to the backend.
+            virtual size_t submit() = 0;
+            // Runs callbacks for completed requests, blocking until at least count of them have
+            // run.  The caller must ensure that at least count requests have been submitted.
+            virtual size_t reap(size_t count) = 0;
+
+        protected:
+            void complete(std::unique_ptr<async_request> request)
+            {
+                --_pending;
+                request->completion(request->error, request->transferred);
+            }
+
+        protected:
+            std::deque<std::unique_ptr<async_request>> _queued;
+
+        private:
+            size_t _pending = 0;
+        };
+    }
+
+    namespace
+    {
+        using _private::async_request;
+        using _private::async_engine;
+
+        constexpr unsigned max_worker_threads = 32;
+
+        std::unique_ptr<async_engine> make_engine(HANDLE handle, unsigned queue_depth, async_file_backend backend);
+
+        class thread_pool_engine final : public async_engine
+        {
+        public:
+            thread_pool_engine(HANDLE handle, unsigned thread_count) : _handle(handle)
+            {
+                _workers.reserve(thread_count);
+                try
+                {
+                    while (thread_count-- != 0)
+                        _workers.emplace_back([this] { run(); });
+                }
+                catch (...)
+                {
+                    stop();
+                    throw;
+                }
+            }
+
+            ~thread_pool_engine() override
+            {
+                stop();
+            }
+
+        public:
+            async_file_backend backend() const noexcept override { return async_file_backend::thread_pool; }
+
+            size_t submit() override
+            {
+                auto count = _queued.size();
+                if (count == 0)
+                    return 0;
+
+                {
+                    std::lock_guard lock(_mutex);
+                    std::move(_queued.begin(), _queued.end(), std::back_inserter(_work));
+                }
+                _queued.clear();
+                _work_ready.notify_all();
+                return count;
+            }
+
+            size_t reap(size_t count) override
+            {
+                size_t reaped = 0;
+                for (;;)
+                {
+                    std::unique_ptr<async_request> request;
+                    {
+                        std::unique_lock lock(_mutex);
+                        if (reaped < count)
+                            _work_done.wait(lock, [this] { return !_completed.empty(); });
+                        else if (_completed.empty())
+                            return reaped;
+
+                        request = stdext::move(_completed.front());
+                        _completed.pop_front();
+                    }
+
+                    ++reaped;
+                    complete(stdext::move(request));
+                }
+            }
+
+        private:
+            void run()
+            {
+                // The file is opened for overlapped I/O so that requests from different workers
+                // proceed concurrently; each worker waits on its own event.
+                auto event = ::CreateEvent(nullptr, TRUE, FALSE, nullptr);
+                at_scope_exit([&] { if (event != nullptr) ::CloseHandle(event); });
+
+                for (;;)
+                {
+                    std::unique_ptr<async_request> request;
+                    {
+                        std::unique_lock lock(_mutex);
+                        _work_ready.wait(lock, [this] { return _stopping || !_work.empty(); });
+                        if (_work.empty())
+                            return;
+
+                        request = stdext::move(_work.front());
+                        _work.pop_front();
+                    }
+
+                    if (event == nullptr)
+                        request->error = { int(::GetLastError()), std::system_category() };
+                    else
+                        perform(*request, event);
+
+                    {
+                        std::lock_guard lock(_mutex);
+                        _completed.push_back(stdext::move(request));
+                    }
+                    _work_done.notify_one();
+                }
+            }
+
+            void perform(async_request& request, HANDLE event) noexcept
+            {
+                constexpr DWORD granularity = 0x1000;
+
+                while (request.transferred != request.size)
+                {
+                    auto position = request.position + request.transferred;
+                    OVERLAPPED overlapped = { };
+                    overlapped.Offset = DWORD(position);
+                    overlapped.OffsetHigh = DWORD(position >> 32);
+                    overlapped.hEvent = event;
+
+                    auto size = request.size - request.transferred;
+                    DWORD chunk_size = size > MAXDWORD ? MAXDWORD & ~(granularity - 1) : DWORD(size);
+                    auto buffer = request.buffer + request.transferred;
+                    auto started = request.write
+                        ? ::WriteFile(_handle, buffer, chunk_size, nullptr, &overlapped)
+                        : ::ReadFile(_handle, buffer, chunk_size, nullptr, &overlapped);
+
+                    DWORD bytes;
+                    if ((!started && ::GetLastError() != ERROR_IO_PENDING)
+                        || !::GetOverlappedResult(_handle, &overlapped, &bytes, TRUE))
+                    {
+                        auto error = ::GetLastError();
+                        if (error != ERROR_HANDLE_EOF)
+                            request.error = { int(error), std::system_category() };
+                        return;
+                    }
+
+                    if (bytes == 0)
+                        return;
+
+                    request.transferred += bytes;
+                }
+            }
+
+            void stop() noexcept
+            {
+                {
+                    std::lock_guard lock(_mutex);
+                    _stopping = true;
+                }
+                _work_ready.notify_all();
+
+                for (auto& worker : _workers)
+                    worker.join();
+            }
+
+        private:
+            HANDLE _handle;
+            std::vector<std::thread> _workers;
+            std::mutex _mutex;
+            std::condition_variable _work_ready;
+            std::condition_variable _work_done;
+            std::deque<std::unique_ptr<async_request>> _work;
+            std::deque<std::unique_ptr<async_request>> _completed;
+            bool _stopping = false;
+        };
+    }
+
+    async_file::async_file() noexcept : _handle(INVALID_HANDLE_VALUE)
+    {
+    }
+
+    async_file::async_file(async_file&& other) noexcept
+        : _handle(stdext::exchange(other._handle, INVALID_HANDLE_VALUE)), _engine(stdext::move(other._engine))
+    {
+    }
+
+    async_file& async_file::operator = (async_file&& other)
+    {
+        if (is_open())
+            close();
+
+        _handle = stdext::exchange(other._handle, INVALID_HANDLE_VALUE);
+        _engine = stdext::move(other._engine);
+        return *this;
+    }
+
+    async_file::~async_file()
+    {
+        if (!is_open())
+            return;
+
+        try
+        {
+            wait_all();
+        }
+        catch (...)
+        {
+        }
+
+        _engine.reset();
+        ::CloseHandle(_handle);
+    }
+
+    async_file::async_file(const path_char* path, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+        : async_file()
+    {
+        if (auto error = open(path, mode, flags, queue_depth, backend))
+            throw std::system_error(error);
+    }
+
+    async_file::async_file(const char* path, utf8_path_encoding, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+        : async_file(reinterpret_cast<const path_char*>(to_u16string(path).second.c_str()), mode, flags, queue_depth, backend)  // TODO: Exception on encoding error
+    {
+    }
+
+    std::error_code async_file::open(const path_char* path, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+    {
+        assert(!is_open());
+        assert(queue_depth != 0);
+
+        auto access = mode == async_file_mode::read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+        auto handle = ::CreateFile(path, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, _private::creation_disposition(flags), FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return { int(::GetLastError()), std::system_category() };
+
+        try
+        {
+            _engine = make_engine(handle, queue_depth, backend);
+        }
+        catch (...)
+        {
+            ::CloseHandle(handle);
+            throw;
+        }
+
+        if (_engine == nullptr)
+        {
+            ::CloseHandle(handle);
+            return make_error_code(std::errc::not_supported);
+        }
+
+        _handle = handle;
+        return { };
+    }
+
+    std::error_code async_file::open(const char* path, utf8_path_encoding, async_file_mode mode, flags<file_open_flags> flags, unsigned queue_depth, async_file_backend backend)
+    {
+        auto path_str = to_u16string(path);
+        if (path_str.first == utf_result::error)
+            return { ERROR_NO_UNICODE_TRANSLATION, std::system_category() };
+
+        return open(reinterpret_cast<const path_char*>(path_str.second.c_str()), mode, flags, queue_depth, backend);
+    }
+
+    bool async_file::is_open() const noexcept
+    {
+        return _handle != INVALID_HANDLE_VALUE;
+    }
+
+    void async_file::close()
+    {
+        assert(is_open());
+
+        wait_all();
+        _engine.reset();
+        ::CloseHandle(_handle);
+        _handle = INVALID_HANDLE_VALUE;
+    }
+
+    async_file_backend async_file::backend() const noexcept
+    {
+        assert(is_open());
+        return _engine->backend();
+    }
+
+    void async_file::read_at(stream_position position, span<byte> buffer, async_completion completion)
+    {
+        assert(is_open());
+        _engine->enqueue(std::make_unique<async_request>(false, position, buffer.data(), buffer.size(), stdext::move(completion)));
+    }
+
+    void async_file::write_at(stream_position position, span<const byte> buffer, async_completion completion)
+    {
+        assert(is_open());
+        _engine->enqueue(std::make_unique<async_request>(true, position, const_cast<byte*>(buffer.data()), buffer.size(), stdext::move(completion)));
+    }
+
+    size_t async_file::submit()
+    {
+        assert(is_open());
+        return _engine->submit();
+    }
+
+    size_t async_file::poll()
+    {
+        assert(is_open());
+        return _engine->reap(0);
+    }
+
+    size_t async_file::wait(size_t count)
+    {
+        assert(is_open());
+        _engine->submit();
+        return _engine->reap(std::min(count, _engine->pending()));
+    }
+
+    void async_file::wait_all()
+    {
+        assert(is_open());
+        while (_engine->pending() != 0)
+            wait(_engine->pending());
+    }
+
+    size_t async_file::pending() const noexcept
+    {
+        return is_open() ? _engine->pending() : 0;
+    }
+
+    namespace
+    {
+        // Returns null if the requested backend is unavailable.
+        std::unique_ptr<async_engine> make_engine(HANDLE handle, unsigned queue_depth, async_file_backend backend)
+        {
+            if (backend == async_file_backend::io_uring)
+                return nullptr;
+
+            return std::make_unique<thread_pool_engine>(handle, std::min(queue_depth, max_worker_threads));
+        }
+    }
+}
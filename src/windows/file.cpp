@@ -1,6 +1,8 @@
 #include <stdext/file.h>
+#include <stdext/scope_guard.h>
 #include <stdext/unicode.h>
 
+#include "open_flags.h"
 #include "platform.h"
 
 #include <algorithm>
@@ -37,7 +39,6 @@ namespace stdext
             file_handle_t handle;
         };
 
-        DWORD creation_disposition(flags<file_open_flags> flags);
     }
 
     namespace _private
@@ -46,7 +47,8 @@ namespace stdext
         {
         }
 
-        file_stream_base::file_stream_base(file_stream_base&& other) : handle(stdext::move(other.handle))
+        file_stream_base::file_stream_base(file_stream_base&& other)
+            : handle(stdext::move(other.handle)), _read_handle(other._read_handle.exchange(nullptr)), _write_handle(other._write_handle.exchange(nullptr))
         {
             other.handle = INVALID_HANDLE_VALUE;
         }
@@ -58,11 +60,14 @@ namespace stdext
 
             handle = stdext::move(other.handle);
             other.handle = INVALID_HANDLE_VALUE;
+            _read_handle = other._read_handle.exchange(nullptr);
+            _write_handle = other._write_handle.exchange(nullptr);
             return *this;
         }
 
         file_stream_base::~file_stream_base()
         {
+            close_positional_handles();
             ::CloseHandle(handle);
         }
 
@@ -81,6 +86,7 @@ namespace stdext
         {
             assert(is_open());
 
+            close_positional_handles();
             ::CloseHandle(handle);
             handle = INVALID_HANDLE_VALUE;
         }
@@ -117,6 +123,114 @@ namespace stdext
                 throw std::system_error(::GetLastError(), std::system_category());
         }
 
+        size_t file_stream_base::read_at_impl(stream_position position, byte* buffer, size_t size) const
+        {
+            assert(is_open());
+
+            constexpr DWORD granularity = 0x1000;
+
+            auto file = positional_handle(_read_handle, GENERIC_READ);
+            auto event = ::CreateEvent(nullptr, TRUE, FALSE, nullptr);
+            if (event == nullptr)
+                throw std::system_error(::GetLastError(), std::system_category());
+            at_scope_exit([&] { ::CloseHandle(event); });
+
+            auto p = buffer;
+            size_t bytes = 0;
+            while (size != 0)
+            {
+                OVERLAPPED overlapped = { };
+                overlapped.Offset = DWORD(position);
+                overlapped.OffsetHigh = DWORD(position >> 32);
+                overlapped.hEvent = event;
+
+                DWORD chunk_size = size > MAXDWORD ? MAXDWORD & ~(granularity - 1) : DWORD(size);
+                DWORD chunk_bytes;
+                if ((!::ReadFile(file, p, chunk_size, nullptr, &overlapped) && ::GetLastError() != ERROR_IO_PENDING)
+                    || !::GetOverlappedResult(file, &overlapped, &chunk_bytes, TRUE))
+                {
+                    auto error = ::GetLastError();
+                    if (error == ERROR_HANDLE_EOF)
+                        break;
+                    throw std::system_error(error, std::system_category());
+                }
+                if (chunk_bytes == 0)
+                    break;
+                size -= chunk_bytes;
+                bytes += chunk_bytes;
+                p += chunk_bytes;
+                position += chunk_bytes;
+            }
+
+            return bytes;
+        }
+
+        size_t file_stream_base::write_at_impl(stream_position position, const byte* buffer, size_t size)
+        {
+            assert(is_open());
+
+            constexpr DWORD granularity = 0x1000;
+
+            auto file = positional_handle(_write_handle, GENERIC_WRITE);
+            auto event = ::CreateEvent(nullptr, TRUE, FALSE, nullptr);
+            if (event == nullptr)
+                throw std::system_error(::GetLastError(), std::system_category());
+            at_scope_exit([&] { ::CloseHandle(event); });
+
+            auto p = buffer;
+            size_t bytes = 0;
+            while (size != 0)
+            {
+                OVERLAPPED overlapped = { };
+                overlapped.Offset = DWORD(position);
+                overlapped.OffsetHigh = DWORD(position >> 32);
+                overlapped.hEvent = event;
+
+                DWORD chunk_size = size > MAXDWORD ? MAXDWORD & ~(granularity - 1) : DWORD(size);
+                DWORD chunk_bytes;
+                if ((!::WriteFile(file, p, chunk_size, nullptr, &overlapped) && ::GetLastError() != ERROR_IO_PENDING)
+                    || !::GetOverlappedResult(file, &overlapped, &chunk_bytes, TRUE))
+                    throw std::system_error(::GetLastError(), std::system_category());
+                if (chunk_bytes < chunk_size)
+                    return bytes + chunk_bytes;
+                size -= chunk_bytes;
+                bytes += chunk_bytes;
+                p += chunk_bytes;
+                position += chunk_bytes;
+            }
+
+            return bytes;
+        }
+
+        file_handle_t file_stream_base::positional_handle(std::atomic<file_handle_t>& slot, unsigned long access) const
+        {
+            if (auto file = slot.load(std::memory_order_acquire))
+                return file;
+
+            // The reopened handle refers to the same file, but has a position of its own.
+            auto file = ::ReOpenFile(handle, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_FLAG_OVERLAPPED);
+            if (file == INVALID_HANDLE_VALUE)
+                throw std::system_error(::GetLastError(), std::system_category());
+
+            // Another thread may have gotten there first.
+            file_handle_t expected = nullptr;
+            if (!slot.compare_exchange_strong(expected, file, std::memory_order_acq_rel))
+            {
+                ::CloseHandle(file);
+                return expected;
+            }
+
+            return file;
+        }
+
+        void file_stream_base::close_positional_handles() noexcept
+        {
+            if (auto file = _read_handle.exchange(nullptr))
+                ::CloseHandle(file);
+            if (auto file = _write_handle.exchange(nullptr))
+                ::CloseHandle(file);
+        }
+
         template <typename Stream>
         size_t file_input_stream_base<Stream>::do_read(byte* buffer, size_t size)
         {
@@ -147,19 +261,60 @@ namespace stdext
         {
             assert(self().is_open());
 
+            if (_skip_mode == skip_mode::unknown)
+            {
+                // SetFilePointerEx must not be used on pipes or other non-seeking devices.
+                _skip_mode = ::GetFileType(self().handle) == FILE_TYPE_DISK ? skip_mode::seek : skip_mode::read;
+                if (_skip_mode == skip_mode::seek)
+                {
+                    LARGE_INTEGER file_size;
+                    if (!::GetFileSizeEx(self().handle, &file_size))
+                        throw std::system_error(::GetLastError(), std::system_category());
+
+                    _end_hint = file_size.QuadPart;
+                }
+            }
+
+            if (_skip_mode == skip_mode::read)
+                return skip_by_reading(size);
+
+            // A skip no longer than the file can't overflow the offset, so the common case is a
+            // single relative seek.
+            stream_position start;
+            LARGE_INTEGER position;
+            if (size <= _end_hint)
+            {
+                LARGE_INTEGER distance;
+                distance.QuadPart = LONGLONG(size);
+                if (!::SetFilePointerEx(self().handle, distance, &position, FILE_CURRENT))
+                    throw std::system_error(::GetLastError(), std::system_category());
+
+                if (stream_position(position.QuadPart) <= _end_hint)
+                    return size;
+
+                start = stream_position(position.QuadPart) - size;
+            }
+            else
+            {
+                if (!::SetFilePointerEx(self().handle, { }, &position, FILE_CURRENT))
+                    throw std::system_error(::GetLastError(), std::system_category());
+
+                start = stream_position(position.QuadPart);
+            }
+
+            // The skip goes past the end of the file as last observed; the file may have grown.
             LARGE_INTEGER file_size;
             if (!::GetFileSizeEx(self().handle, &file_size))
                 throw std::system_error(::GetLastError(), std::system_category());
 
-            LARGE_INTEGER distance;
-            if (!::SetFilePointerEx(self().handle, LARGE_INTEGER(), &distance, FILE_CURRENT))
+            _end_hint = file_size.QuadPart;
+            auto skipped = start < _end_hint ? std::min(stream_position(size), _end_hint - start) : 0;
+            LARGE_INTEGER target;
+            target.QuadPart = LONGLONG(start + skipped);
+            if (!::SetFilePointerEx(self().handle, target, nullptr, FILE_BEGIN))
                 throw std::system_error(::GetLastError(), std::system_category());
 
-            distance.QuadPart = std::min(static_cast<LONGLONG>(size), file_size.QuadPart - distance.QuadPart);
-            if (!::SetFilePointerEx(self().handle, distance, nullptr, FILE_CURRENT))
-                throw std::system_error(::GetLastError(), std::system_category());
-
-            return static_cast<size_t>(distance.QuadPart);
+            return size_t(skipped);
         }
 
         template <typename Stream>
@@ -186,6 +341,106 @@ namespace stdext
 
             return bytes;
         }
+
+        file_mapping::file_mapping(file_mapping&& other) noexcept
+            : _data(stdext::exchange(other._data, nullptr)), _size(stdext::exchange(other._size, 0)), _open(stdext::exchange(other._open, false))
+        {
+        }
+
+        file_mapping& file_mapping::operator = (file_mapping&& other) noexcept
+        {
+            if (is_open())
+                close();
+
+            _data = stdext::exchange(other._data, nullptr);
+            _size = stdext::exchange(other._size, 0);
+            _open = stdext::exchange(other._open, false);
+            return *this;
+        }
+
+        file_mapping::~file_mapping()
+        {
+            if (is_open())
+                close();
+        }
+
+        std::error_code file_mapping::open(const path_char* path, bool writable, mapped_file_access access, flags<mapped_file_flags> flags)
+        {
+            assert(!is_open());
+
+            // Windows has no madvise; the access pattern is instead conveyed to the cache
+            // manager when the file is opened.
+            DWORD attributes = access == mapped_file_access::sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+                : access == mapped_file_access::random ? FILE_FLAG_RANDOM_ACCESS
+                : FILE_ATTRIBUTE_NORMAL;
+            auto file = ::CreateFile(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, attributes, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return { int(::GetLastError()), std::system_category() };
+            at_scope_exit([&] { ::CloseHandle(file); });
+
+            LARGE_INTEGER size;
+            if (!::GetFileSizeEx(file, &size))
+                return { int(::GetLastError()), std::system_category() };
+
+            // Large pages can only back pagefile sections on Windows, so the flag has no effect
+            // on a file mapping.
+            discard(flags);
+
+            // CreateFileMapping rejects empty files, so an empty file is left unmapped.
+            if (size.QuadPart != 0)
+            {
+                auto mapping = ::CreateFileMapping(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+                if (mapping == nullptr)
+                    return { int(::GetLastError()), std::system_category() };
+                at_scope_exit([&] { ::CloseHandle(mapping); });
+
+                auto data = ::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+                if (data == nullptr)
+                    return { int(::GetLastError()), std::system_category() };
+
+                _data = static_cast<byte*>(data);
+                _size = size_t(size.QuadPart);
+            }
+
+            _open = true;
+            return { };
+        }
+
+        std::error_code file_mapping::open(const char* path, utf8_path_encoding, bool writable, mapped_file_access access, flags<mapped_file_flags> flags)
+        {
+            auto path_str = to_u16string(path);
+            if (path_str.first == utf_result::error)
+                return { ERROR_NO_UNICODE_TRANSLATION, std::system_category() };
+
+            return open(reinterpret_cast<const path_char*>(path_str.second.c_str()), writable, access, flags);
+        }
+
+        void file_mapping::close() noexcept
+        {
+            if (_data != nullptr)
+                ::UnmapViewOfFile(_data);
+
+            _data = nullptr;
+            _size = 0;
+            _open = false;
+        }
+
+        void file_mapping::advise(mapped_file_access access)
+        {
+            assert(is_open());
+            discard(access);
+        }
+
+        void file_mapping::flush()
+        {
+            assert(is_open());
+
+            if (_size == 0)
+                return;
+
+            if (!::FlushViewOfFile(_data, 0))
+                throw std::system_error(::GetLastError(), std::system_category());
+        }
     }
 
     file_input_stream::file_input_stream(const path_char* path)
@@ -208,6 +463,7 @@ namespace stdext
         if (handle == INVALID_HANDLE_VALUE)
             return { int(::GetLastError()), std::system_category() };
 
+        reset_skip_state();
         return { };
     }
 
@@ -223,7 +479,7 @@ namespace stdext
     }
 
     file_output_stream::file_output_stream(const path_char* path, flags<file_open_flags> flags)
-        : file_stream_base(::CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr))
+        : file_stream_base(::CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, _private::creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr))
     {
     }
 
@@ -238,7 +494,7 @@ namespace stdext
     {
         assert(!is_open());
 
-        handle = ::CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr);
+        handle = ::CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, _private::creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr);
         if (handle == INVALID_HANDLE_VALUE)
             return { int(::GetLastError()), std::system_category() };
 
@@ -257,7 +513,7 @@ namespace stdext
     }
 
     file_stream::file_stream(const path_char* path, flags<file_open_flags> flags)
-        : file_stream_base(::CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr))
+        : file_stream_base(::CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, _private::creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr))
     {
     }
 
@@ -272,10 +528,11 @@ namespace stdext
     {
         assert(!is_open());
 
-        handle = ::CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr);
+        handle = ::CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, _private::creation_disposition(flags), FILE_ATTRIBUTE_NORMAL, nullptr);
         if (handle == INVALID_HANDLE_VALUE)
             return { int(::GetLastError()), std::system_category() };
 
+        reset_skip_state();
         return { };
     }
 
@@ -290,6 +547,114 @@ namespace stdext
         return open(reinterpret_cast<const path_char*>(path_str.second.c_str()), flags);
     }
 
+    mapped_file_input_stream::mapped_file_input_stream(mapped_file_input_stream&& other) noexcept
+        : memory_stream_base<const byte*>(other), _mapping(stdext::move(other._mapping))
+    {
+        other.reset();
+    }
+
+    mapped_file_input_stream& mapped_file_input_stream::operator = (mapped_file_input_stream&& other) noexcept
+    {
+        memory_stream_base<const byte*>::operator = (other);
+        _mapping = stdext::move(other._mapping);
+        other.reset();
+        return *this;
+    }
+
+    mapped_file_input_stream::~mapped_file_input_stream() = default;
+
+    mapped_file_input_stream::mapped_file_input_stream(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, access, flags))
+            throw std::system_error(error);
+    }
+
+    mapped_file_input_stream::mapped_file_input_stream(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, utf8_path_encoding(), access, flags))
+            throw std::system_error(error);
+    }
+
+    std::error_code mapped_file_input_stream::open(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, false, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    std::error_code mapped_file_input_stream::open(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, utf8_path_encoding(), false, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    void mapped_file_input_stream::close() noexcept
+    {
+        assert(is_open());
+
+        reset();
+        _mapping.close();
+    }
+
+    mapped_file_stream::mapped_file_stream(mapped_file_stream&& other) noexcept
+        : memory_stream_base<byte*>(other), _mapping(stdext::move(other._mapping))
+    {
+        other.reset();
+    }
+
+    mapped_file_stream& mapped_file_stream::operator = (mapped_file_stream&& other) noexcept
+    {
+        memory_stream_base<byte*>::operator = (other);
+        _mapping = stdext::move(other._mapping);
+        other.reset();
+        return *this;
+    }
+
+    mapped_file_stream::~mapped_file_stream() = default;
+
+    mapped_file_stream::mapped_file_stream(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, access, flags))
+            throw std::system_error(error);
+    }
+
+    mapped_file_stream::mapped_file_stream(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        if (auto error = open(path, utf8_path_encoding(), access, flags))
+            throw std::system_error(error);
+    }
+
+    std::error_code mapped_file_stream::open(const path_char* path, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, true, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    std::error_code mapped_file_stream::open(const char* path, utf8_path_encoding, mapped_file_access access, flags<mapped_file_flags> flags)
+    {
+        auto error = _mapping.open(path, utf8_path_encoding(), true, access, flags);
+        if (!error)
+            reset(_mapping.data(), _mapping.size());
+
+        return error;
+    }
+
+    void mapped_file_stream::close() noexcept
+    {
+        assert(is_open());
+
+        reset();
+        _mapping.close();
+    }
+
     input_stream& in()
     {
         static std_input_stream in(::GetStdHandle(STD_INPUT_HANDLE));
@@ -307,29 +672,4 @@ namespace stdext
         static std_output_stream err(::GetStdHandle(STD_ERROR_HANDLE));
         return err;
     }
-
-    namespace
-    {
-        DWORD creation_disposition(flags<file_open_flags> flags)
-        {
-            switch (flags)
-            {
-            case file_open_flags::none:
-                return OPEN_EXISTING;
-            case file_open_flags::create:
-                return OPEN_ALWAYS;
-            case file_open_flags::create_exclusive:
-                return CREATE_NEW;
-            case file_open_flags::truncate:
-                return TRUNCATE_EXISTING;
-#if STDEXT_COMPILER_MSVC
-#pragma warning(disable:4063)   // case '5' is not a valid value for switch of enum 'stdext::file_open_flags'
-#endif
-            case stdext::flags<file_open_flags>(file_open_flags::create, file_open_flags::truncate):
-                return CREATE_ALWAYS;
-            }
-
-            return DWORD(-1);
-        }
-    }
 }
@@ -0,0 +1,43 @@
+#ifndef STDEXT_IMPL_OPEN_FLAGS_INCLUDED
+#define STDEXT_IMPL_OPEN_FLAGS_INCLUDED
+#pragma once
+
+#include <stdext/file.h>
+
+#include "platform.h"
+
+
+namespace stdext
+{
+    namespace _private
+    {
+        // The CreateFile creation disposition that carries out file_open_flags.
+        inline DWORD creation_disposition(flags<file_open_flags> flags) noexcept
+        {
+#if STDEXT_COMPILER_MSVC
+#pragma warning(push)
+#pragma warning(disable:4063)   // case '5' is not a valid value for switch of enum 'stdext::file_open_flags'
+#endif
+            switch (flags)
+            {
+            case file_open_flags::none:
+                return OPEN_EXISTING;
+            case file_open_flags::create:
+                return OPEN_ALWAYS;
+            case file_open_flags::create_exclusive:
+                return CREATE_NEW;
+            case file_open_flags::truncate:
+                return TRUNCATE_EXISTING;
+            case stdext::flags<file_open_flags>(file_open_flags::create, file_open_flags::truncate):
+                return CREATE_ALWAYS;
+            }
+#if STDEXT_COMPILER_MSVC
+#pragma warning(pop)
+#endif
+
+            return DWORD(-1);
+        }
+    }
+}
+
+#endif
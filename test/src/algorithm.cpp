@@ -0,0 +1,249 @@
+#include <stdext/algorithm.h>
+#include <stdext/array_view.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace test
+{
+    namespace
+    {
+        // Long enough that the parallel algorithms split the work.
+        constexpr size_t large_size = 200000;
+
+        std::vector<std::vector<int>> inputs(size_t size)
+        {
+            std::mt19937 engine(5);
+            std::vector<std::vector<int>> result;
+
+            auto& random = result.emplace_back(size);
+            for (auto& value : random)
+                value = int(engine());
+
+            auto& few = result.emplace_back(size);
+            for (auto& value : few)
+                value = int(engine() % 4);
+
+            auto& sorted = result.emplace_back(size);
+            for (size_t n = 0; n != size; ++n)
+                sorted[n] = int(n);
+
+            auto& reversed = result.emplace_back(size);
+            for (size_t n = 0; n != size; ++n)
+                reversed[n] = int(size - n);
+
+            result.emplace_back(size, 42);
+
+            // Ascending, then descending: defeats a median-of-three pivot.
+            auto& organ = result.emplace_back(size);
+            for (size_t n = 0; n != size; ++n)
+                organ[n] = int(std::min(n, size - n));
+
+            return result;
+        }
+
+        std::vector<std::pair<int, size_t>> keyed(size_t size)
+        {
+            std::mt19937 engine(9);
+            std::vector<std::pair<int, size_t>> result(size);
+            for (size_t n = 0; n != size; ++n)
+                result[n] = { int(engine() % 100), n };
+            return result;
+        }
+
+        constexpr auto by_key = [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b)
+        {
+            return a.first < b.first;
+        };
+    }
+
+    static_assert(stdext::is_execution_policy_v<stdext::execution::sequenced_policy>);
+    static_assert(stdext::is_execution_policy_v<stdext::execution::parallel_policy>);
+    static_assert(!stdext::is_execution_policy_v<int>);
+
+    TEST_CASE("sort", "[algorithm]")
+    {
+        for (auto size : { size_t(0), size_t(1), size_t(15), size_t(100), size_t(5000), large_size })
+        {
+            for (auto& input : inputs(size))
+            {
+                auto expected = input;
+                std::sort(expected.begin(), expected.end());
+
+                auto values = input;
+                stdext::sort(stdext::array_view<int>(values.data(), values.size()));
+                CHECK(values == expected);
+
+                values = input;
+                stdext::sort(stdext::execution::par, stdext::array_view<int>(values.data(), values.size()));
+                CHECK(values == expected);
+
+                values = input;
+                stdext::sort(stdext::execution::seq, stdext::array_view<int>(values.data(), values.size()), std::greater<>());
+                CHECK(std::equal(values.begin(), values.end(), expected.rbegin()));
+            }
+        }
+    }
+
+    TEST_CASE("sort on a range of iterators", "[algorithm]")
+    {
+        for (auto& input : inputs(large_size))
+        {
+            auto expected = input;
+            std::sort(expected.begin(), expected.end());
+
+            std::deque<int> values(input.begin(), input.end());
+            stdext::sort(stdext::delimited_iterator_range<std::deque<int>::iterator>(values.begin(), values.end()));
+            CHECK(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+
+            values.assign(input.begin(), input.end());
+            stdext::sort(stdext::execution::par, stdext::delimited_iterator_range<std::deque<int>::iterator>(values.begin(), values.end()));
+            CHECK(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+        }
+    }
+
+    TEST_CASE("stable_sort", "[algorithm]")
+    {
+        for (auto size : { size_t(0), size_t(1), size_t(15), size_t(100), size_t(5000), large_size })
+        {
+            auto input = keyed(size);
+            auto expected = input;
+            std::stable_sort(expected.begin(), expected.end(), by_key);
+
+            auto values = input;
+            stdext::stable_sort(stdext::array_view<std::pair<int, size_t>>(values.data(), values.size()), by_key);
+            CHECK(values == expected);
+
+            values = input;
+            stdext::stable_sort(stdext::execution::par, stdext::array_view<std::pair<int, size_t>>(values.data(), values.size()), by_key);
+            CHECK(values == expected);
+
+            std::deque<std::pair<int, size_t>> deque(input.begin(), input.end());
+            stdext::stable_sort(stdext::execution::par,
+                stdext::delimited_iterator_range<std::deque<std::pair<int, size_t>>::iterator>(deque.begin(), deque.end()), by_key);
+            CHECK(std::equal(deque.begin(), deque.end(), expected.begin(), expected.end()));
+        }
+
+        for (auto& input : inputs(large_size))
+        {
+            auto expected = input;
+            std::sort(expected.begin(), expected.end());
+
+            auto values = input;
+            stdext::stable_sort(stdext::execution::par, stdext::array_view<int>(values.data(), values.size()));
+            CHECK(values == expected);
+        }
+    }
+
+    TEST_CASE("nth_element", "[algorithm]")
+    {
+        for (auto size : { size_t(1), size_t(15), size_t(100), size_t(5000), large_size })
+        {
+            for (auto& input : inputs(size))
+            {
+                auto expected = input;
+                std::sort(expected.begin(), expected.end());
+
+                for (auto nth : { size_t(0), size / 3, size - 1 })
+                {
+                    auto values = input;
+                    stdext::array_view<int> view(values.data(), values.size());
+                    stdext::nth_element(view, view.begin_pos() + nth);
+                    REQUIRE(values[nth] == expected[nth]);
+                    CHECK(std::all_of(values.begin(), values.begin() + nth, [&](int value) { return value <= expected[nth]; }));
+                    CHECK(std::all_of(values.begin() + nth, values.end(), [&](int value) { return value >= expected[nth]; }));
+
+                    values = input;
+                    stdext::nth_element(stdext::execution::par, view, view.begin_pos() + nth);
+                    REQUIRE(values[nth] == expected[nth]);
+                    CHECK(std::all_of(values.begin(), values.begin() + nth, [&](int value) { return value <= expected[nth]; }));
+                    CHECK(std::all_of(values.begin() + nth, values.end(), [&](int value) { return value >= expected[nth]; }));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("parallel algorithms propagate exceptions", "[algorithm]")
+    {
+        auto values = inputs(large_size).front();
+        stdext::array_view<int> view(values.data(), values.size());
+        std::atomic<size_t> count = 0;
+        auto comp = [&](int a, int b)
+        {
+            if (++count == 100000)
+                throw std::runtime_error("comparison failed");
+            return a < b;
+        };
+
+        CHECK_THROWS_AS(stdext::sort(stdext::execution::par, view, comp), std::runtime_error);
+    }
+
+    TEST_CASE("parallel algorithms on several threads", "[algorithm]")
+    {
+        // However many cores this machine has, run the work on a pool of several threads, with
+        // several callers sharing the pool at once.
+        stdext::_private::scoped_thread_pool pool(4);
+        REQUIRE(stdext::_private::parallel_concurrency() == 4);
+
+        auto run = [](unsigned seed)
+        {
+            std::mt19937 engine(seed);
+            std::vector<int> input(large_size);
+            for (auto& value : input)
+                value = int(engine() % 1000);
+
+            auto expected = input;
+            std::sort(expected.begin(), expected.end());
+
+            auto values = input;
+            stdext::array_view<int> view(values.data(), values.size());
+            stdext::sort(stdext::execution::par, view);
+            if (values != expected)
+                return false;
+
+            values = input;
+            stdext::nth_element(stdext::execution::par, view, view.begin_pos() + large_size / 2);
+            if (values[large_size / 2] != expected[large_size / 2])
+                return false;
+
+            std::vector<std::pair<int, size_t>> pairs(large_size);
+            for (size_t n = 0; n != large_size; ++n)
+                pairs[n] = { input[n], n };
+            auto expected_pairs = pairs;
+            std::stable_sort(expected_pairs.begin(), expected_pairs.end(), by_key);
+            stdext::stable_sort(stdext::execution::par, stdext::array_view<std::pair<int, size_t>>(pairs.data(), pairs.size()), by_key);
+            return pairs == expected_pairs;
+        };
+
+        REQUIRE(run(1));
+
+        constexpr unsigned caller_count = 4;
+        std::atomic<unsigned> succeeded = 0;
+        std::vector<std::thread> callers;
+        for (unsigned n = 0; n != caller_count; ++n)
+            callers.emplace_back([&, n] { succeeded += unsigned(run(n + 2)); });
+        for (auto& caller : callers)
+            caller.join();
+        REQUIRE(succeeded == caller_count);
+
+        auto values = inputs(large_size).front();
+        stdext::array_view<int> view(values.data(), values.size());
+        std::atomic<size_t> count = 0;
+        auto comp = [&](int a, int b)
+        {
+            if (++count == 100000)
+                throw std::runtime_error("comparison failed");
+            return a < b;
+        };
+        CHECK_THROWS_AS(stdext::sort(stdext::execution::par, view, comp), std::runtime_error);
+    }
+}
@@ -0,0 +1,88 @@
+#include <stdext/async_file.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+
+namespace test
+{
+    namespace
+    {
+        void test_async_file(stdext::async_file_backend backend)
+        {
+            constexpr size_t block_size = 0x1000;
+            constexpr size_t block_count = 64;
+            constexpr auto path = PATH_STR("async-file.bin");
+
+            std::unique_ptr<stdext::byte[]> data(new stdext::byte[block_size * block_count]);
+            for (size_t n = 0; n != block_size * block_count; ++n)
+                data[n] = stdext::byte(n * 7 % 251);
+
+            {
+                stdext::async_file file(path, stdext::async_file_mode::read_write, { stdext::file_open_flags::create, stdext::file_open_flags::truncate }, 16, backend);
+                if (backend != stdext::async_file_backend::automatic)
+                    REQUIRE(file.backend() == backend);
+                size_t written = 0;
+                for (size_t block = 0; block != block_count; ++block)
+                {
+                    file.write_at(block * block_size, { data.get() + block * block_size, block_size }, [&](const std::error_code& error, size_t size)
+                    {
+                        REQUIRE(!error);
+                        written += size;
+                    });
+                }
+
+                REQUIRE(file.pending() == block_count);
+                file.wait_all();
+                REQUIRE(file.pending() == 0);
+                REQUIRE(written == block_size * block_count);
+            }
+
+            stdext::async_file file(path, stdext::async_file_mode::read, stdext::file_open_flags::none, stdext::async_file::default_queue_depth, backend);
+            std::unique_ptr<stdext::byte[]> buffer(new stdext::byte[block_size * block_count]);
+            size_t completed = 0;
+            for (size_t block = block_count; block-- != 0; )
+            {
+                file.read_at(block * block_size, { buffer.get() + block * block_size, block_size }, [&](const std::error_code& error, size_t size)
+                {
+                    REQUIRE(!error);
+                    REQUIRE(size == block_size);
+                    ++completed;
+                });
+            }
+
+            REQUIRE(file.submit() != 0);
+            REQUIRE(file.wait(4) >= 4);
+            file.wait_all();
+            REQUIRE(completed == block_count);
+            REQUIRE(std::equal(buffer.get(), buffer.get() + block_size * block_count, data.get()));
+
+            stdext::byte tail[block_size];
+            size_t tail_size = 0;
+            file.read_at(block_size * block_count - 10, tail, [&](const std::error_code& error, size_t size)
+            {
+                REQUIRE(!error);
+                tail_size = size;
+            });
+            REQUIRE(file.wait() == 1);
+            REQUIRE(tail_size == 10);
+            REQUIRE(file.poll() == 0);
+
+            file.close();
+            std::remove("async-file.bin");
+        }
+    }
+
+    TEST_CASE("Asynchronous file operations", "[file]")
+    {
+        test_async_file(stdext::async_file_backend::automatic);
+    }
+
+    TEST_CASE("Asynchronous file operations on the thread pool backend", "[file]")
+    {
+        test_async_file(stdext::async_file_backend::thread_pool);
+    }
+}
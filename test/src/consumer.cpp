@@ -43,6 +43,21 @@ namespace test
     static_assert(stdext::is_consumer_v<stdext::iterator_consumer<int*>, int>);
     static_assert(stdext::is_consumer_v<stdext::delimited_iterator_consumer<int*>, int>);
 
+    // is_chunk_consumer
+    static_assert(!stdext::is_chunk_consumer<bool (int), int>::value);
+    static_assert(!stdext::is_chunk_consumer<bool (stdext::span<const int>), int>::value);
+    static_assert(stdext::is_chunk_consumer<size_t (stdext::span<const int>), int>::value);
+    static_assert(stdext::is_chunk_consumer<stdext::iterator_consumer<int*>, int>::value);
+    static_assert(stdext::is_chunk_consumer<stdext::iterator_consumer<long*>, int>::value);
+    static_assert(!stdext::is_chunk_consumer<stdext::iterator_consumer<int**>, int>::value);
+    static_assert(stdext::is_chunk_consumer<stdext::delimited_iterator_consumer<int*>, int>::value);
+
+    // is_chunk_consumer_v
+    static_assert(!stdext::is_chunk_consumer_v<bool (int), int>);
+    static_assert(stdext::is_chunk_consumer_v<size_t (stdext::span<const int>), int>);
+    static_assert(stdext::is_chunk_consumer_v<stdext::iterator_consumer<int*>, int>);
+    static_assert(stdext::is_chunk_consumer_v<stdext::delimited_iterator_consumer<int*>, int>);
+
     // iterator_consumer
     TEST_CASE("iterator_consumer", "[consumer]")
     {
@@ -55,6 +70,19 @@ namespace test
         CHECK(fixed_output_iterator::value == 1729);
     }
 
+    TEST_CASE("iterator_consumer with a chunk", "[consumer]")
+    {
+        const int values[] = { 1, 2, 3, 4 };
+        long a[5] = { };
+        stdext::iterator_consumer consume(std::begin(a));
+        REQUIRE(consume(stdext::span<const int>(values)) == 4);
+        REQUIRE(consume(stdext::span<const int>()) == 0);
+        REQUIRE(consume(5));
+        CHECK(a[0] == 1);
+        CHECK(a[3] == 4);
+        CHECK(a[4] == 5);
+    }
+
     // delimited_iterator_consumer
     TEST_CASE("delimited_iterator_consumer", "[consumer]")
     {
@@ -69,6 +97,20 @@ namespace test
         CHECK_FALSE(consume(420));
     }
 
+    TEST_CASE("delimited_iterator_consumer with a chunk", "[consumer]")
+    {
+        const int values[] = { 1, 2, 3, 4 };
+        int a[6];
+        stdext::delimited_iterator_consumer consume(std::begin(a), std::end(a));
+        REQUIRE(consume(stdext::span<const int>(values)) == 4);
+        REQUIRE(consume(stdext::span<const int>(values)) == 2);
+        CHECK(a[3] == 4);
+        CHECK(a[4] == 1);
+        CHECK(a[5] == 2);
+        CHECK(consume(stdext::span<const int>(values)) == 0);
+        CHECK_FALSE(consume(420));
+    }
+
     // make_consumer
     static_assert(std::is_same_v<decltype(stdext::make_consumer<int>(fixed_output_iterator())), stdext::iterator_consumer<fixed_output_iterator>>);
     static_assert(std::is_same_v<decltype(stdext::make_consumer<int>(std::declval<int*>(), std::declval<int*>())), stdext::delimited_iterator_consumer<int*, int*>>);
@@ -0,0 +1,115 @@
+#include <stdext/endian.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+
+namespace test
+{
+    namespace
+    {
+        template <stdext::byte_order Order, typename T>
+        void check_bulk_swap()
+        {
+            T values[67];
+            for (size_t n = 0; n != std::size(values); ++n)
+                values[n] = T(0x0123456789ABCDEFull * (n + 1));
+
+            for (size_t count = 0; count <= std::size(values); ++count)
+            {
+                T swapped[std::size(values)];
+                stdext::endian_swap<Order>(values, swapped, count);
+                for (size_t n = 0; n != count; ++n)
+                    REQUIRE(swapped[n] == stdext::endian_swap<Order>(values[n]));
+
+                stdext::endian_swap<Order>(stdext::span<T>(swapped, count));
+                REQUIRE(std::equal(swapped, swapped + count, values));
+            }
+        }
+    }
+
+    TEST_CASE("Endian swap", "[endian]")
+    {
+        REQUIRE(stdext::endian_swap<stdext::byte_order::big_endian>(uint16_t(0x0102)) == (stdext::byte_order::native_endian == stdext::byte_order::little_endian ? 0x0201 : 0x0102));
+        REQUIRE(stdext::endian_swap<stdext::byte_order::native_endian>(uint32_t(0x01020304)) == 0x01020304);
+
+        check_bulk_swap<stdext::byte_order::big_endian, uint16_t>();
+        check_bulk_swap<stdext::byte_order::big_endian, int32_t>();
+        check_bulk_swap<stdext::byte_order::big_endian, uint64_t>();
+        check_bulk_swap<stdext::byte_order::little_endian, uint32_t>();
+        check_bulk_swap<stdext::byte_order::pdp_endian, uint32_t>();
+        check_bulk_swap<stdext::byte_order::pdp_endian, uint64_t>();
+        check_bulk_swap<stdext::byte_order::big_endian, uint8_t>();
+    }
+
+    TEST_CASE("Endian stream operations", "[endian]")
+    {
+        constexpr size_t count = 5000;
+        static uint32_t values[count];
+        for (size_t n = 0; n != count; ++n)
+            values[n] = uint32_t(n * 0x01010101u + 0x00020406u);
+
+        static std::byte buffer[count * sizeof(uint32_t)];
+        stdext::memory_output_stream os(buffer, sizeof(buffer));
+        REQUIRE(stdext::write<stdext::byte_order::big_endian>(os, values, count) == count);
+        REQUIRE(os.position() == sizeof(buffer));
+        REQUIRE(buffer[0] == std::byte(0x00));
+        REQUIRE(buffer[3] == std::byte(0x06));
+
+        stdext::memory_input_stream is(buffer, sizeof(buffer));
+        REQUIRE(stdext::read<stdext::byte_order::big_endian, uint32_t>(is) == values[0]);
+        static uint32_t result[count];
+        REQUIRE(stdext::read<stdext::byte_order::big_endian>(is, result + 1, count - 1) == count - 1);
+        REQUIRE(std::equal(result + 1, result + count, values + 1));
+
+        std::byte small[10];
+        stdext::memory_output_stream short_os(small, sizeof(small));
+        REQUIRE_THROWS_AS(stdext::write<stdext::byte_order::big_endian>(short_os, values, 3), stdext::stream_error);
+    }
+
+    TEST_CASE("Endian span", "[endian]")
+    {
+        // Offset by one byte so that the elements are misaligned.
+        std::byte raw[1 + 20 * sizeof(uint32_t) + 3];
+        for (size_t n = 0; n != sizeof(raw); ++n)
+            raw[n] = std::byte(n);
+
+        stdext::endian_span_be<uint32_t> view(stdext::span<const std::byte>(raw + 1, sizeof(raw) - 1));
+        REQUIRE(view.size() == 20);
+        REQUIRE(view.size_bytes() == 20 * sizeof(uint32_t));
+        REQUIRE(view[0] == 0x01020304);
+        REQUIRE(view.front() == 0x01020304);
+        REQUIRE(view.back() == 0x4D4E4F50);
+        REQUIRE(view[2] == 0x090A0B0C);
+
+        auto it = view.begin();
+        REQUIRE(*it == 0x01020304);
+        REQUIRE(it[1] == 0x05060708);
+        it += 2;
+        REQUIRE(*it == 0x090A0B0C);
+        REQUIRE(view.end() - view.begin() == 20);
+        REQUIRE(std::distance(view.rbegin(), view.rend()) == 20);
+        REQUIRE(*view.rbegin() == view.back());
+
+        size_t count = 0;
+        for (auto v : view)
+            REQUIRE(v == view[count++]);
+        REQUIRE(count == 20);
+
+        auto sub = view.subspan(5, 3);
+        REQUIRE(sub.size() == 3);
+        REQUIRE(sub[0] == view[5]);
+        REQUIRE(view.last(2)[0] == view[18]);
+
+        uint32_t native[25];
+        REQUIRE(view.copy_to_native(native) == 20);
+        REQUIRE(std::equal(native, native + 20, view.begin()));
+
+        stdext::endian_span_le<uint16_t> le_view(raw + 1, 4);
+        REQUIRE(le_view[0] == 0x0201);
+        uint16_t le_native[2];
+        REQUIRE(le_view.copy_to_native(le_native) == 2);
+        REQUIRE(le_native[1] == 0x0403);
+    }
+}
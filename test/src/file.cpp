@@ -0,0 +1,206 @@
+#include <stdext/file.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace test
+{
+    TEST_CASE("Mapped file input stream", "[file]")
+    {
+        stdext::file_input_stream file(PATH_STR("UTF-8-test.txt"));
+        stdext::mapped_file_input_stream mapped(PATH_STR("UTF-8-test.txt"), stdext::mapped_file_access::sequential);
+        REQUIRE(mapped.is_open());
+        REQUIRE(mapped.end_position() == file.end_position());
+
+        SECTION("read")
+        {
+            REQUIRE(mapped.peek<char>() == file.read<char>());
+            mapped.skip<char>();
+            REQUIRE(std::equal(stdext::input_stream_iterator<std::byte>(file), stdext::input_stream_iterator<std::byte>(),
+                stdext::input_stream_iterator<std::byte>(mapped)));
+        }
+
+        SECTION("direct_read")
+        {
+            const std::byte* first = nullptr;
+            size_t total = mapped.direct_read([&](const std::byte* buffer, size_t size)
+            {
+                first = buffer;
+                return size;
+            });
+            REQUIRE(total == mapped.end_position());
+            REQUIRE(mapped.position() == mapped.end_position());
+
+            mapped.seek(stdext::seek_from::begin, 16);
+            mapped.advise(stdext::mapped_file_access::random);
+            size_t count = mapped.direct_read([&](const std::byte* buffer, size_t)
+            {
+                REQUIRE(buffer == first + 16);
+                return size_t(0);
+            });
+            REQUIRE(count == 0);
+        }
+
+        SECTION("move")
+        {
+            mapped.skip<char>();
+            stdext::mapped_file_input_stream other(std::move(mapped));
+            REQUIRE(!mapped.is_open());
+            REQUIRE(other.position() == 1);
+            other.close();
+            REQUIRE(!other.is_open());
+        }
+    }
+
+    TEST_CASE("Mapped file stream", "[file]")
+    {
+        const stdext::path_char* path = PATH_STR("mapped-file-stream.bin");
+        const std::uint32_t data[] = { 0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210 };
+
+        {
+            stdext::file_output_stream out(path);
+            out.write_all(data);
+        }
+
+        {
+            stdext::mapped_file_stream mapped(path);
+            REQUIRE(mapped.end_position() == sizeof(data));
+            REQUIRE(mapped.read<std::uint32_t>() == data[0]);
+            mapped.write(std::uint32_t(0));
+            REQUIRE(mapped.read<std::uint32_t>() == data[2]);
+            REQUIRE(mapped.write(data, 2) == 1);
+            mapped.flush();
+        }
+
+        {
+            stdext::file_input_stream in(path);
+            REQUIRE(in.read<std::uint32_t>() == data[0]);
+            REQUIRE(in.read<std::uint32_t>() == 0);
+            REQUIRE(in.read<std::uint32_t>() == data[2]);
+            REQUIRE(in.read<std::uint32_t>() == data[0]);
+        }
+
+        std::remove("mapped-file-stream.bin");
+    }
+
+    TEST_CASE("Vectored file operations", "[file]")
+    {
+        const stdext::path_char* path = PATH_STR("vectored-file-stream.bin");
+        const std::uint32_t header = 0xFEEDFACE;
+        const char payload[] = "payload";
+        const std::uint16_t trailer = 0xBEEF;
+
+        {
+            stdext::file_output_stream out(path);
+            const stdext::span<const std::byte> buffers[] =
+            {
+                stdext::as_bytes(stdext::span<const std::uint32_t>(&header, 1)),
+                stdext::as_bytes(stdext::span<const char>(payload)),
+                stdext::as_bytes(stdext::span<const std::uint16_t>(&trailer, 1)),
+            };
+            out.write_all_vectored(buffers);
+            REQUIRE(out.position() == sizeof(header) + sizeof(payload) + sizeof(trailer));
+        }
+
+        {
+            stdext::file_input_stream in(path);
+            std::uint32_t h;
+            char p[sizeof(payload)];
+            std::uint16_t t;
+            const stdext::span<std::byte> buffers[] =
+            {
+                stdext::as_writable_bytes(stdext::span<std::uint32_t>(&h, 1)),
+                stdext::as_writable_bytes(stdext::span<char>(p)),
+                stdext::as_writable_bytes(stdext::span<std::uint16_t>(&t, 1)),
+            };
+            in.read_all_vectored(buffers);
+            REQUIRE(h == header);
+            REQUIRE(std::equal(p, p + sizeof(p), payload));
+            REQUIRE(t == trailer);
+            REQUIRE(in.read_vectored(buffers) == 0);
+        }
+
+        std::remove("vectored-file-stream.bin");
+    }
+
+    TEST_CASE("Positional file operations", "[file]")
+    {
+        const stdext::path_char* path = PATH_STR("positional-file-stream.bin");
+        const std::uint32_t data[] = { 0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210 };
+
+        {
+            stdext::file_output_stream file(path);
+            file.write_all_at(4, data + 1, 3);
+            file.write_at(0, data[0]);
+            REQUIRE(file.end_position() == sizeof(data));
+        }
+
+        {
+            stdext::file_input_stream file(path);
+            REQUIRE(file.read_at<std::uint32_t>(8) == data[2]);
+            std::uint32_t buffer[4];
+            REQUIRE(file.read_at(12, buffer, 4) == 1);
+            REQUIRE(buffer[0] == data[3]);
+            REQUIRE(file.read_at(16, buffer, 4) == 0);
+        }
+
+        {
+            const stdext::file_input_stream file(path);
+            std::uint32_t buffer[4];
+            file.read_all_at(0, buffer, 4);
+            REQUIRE(std::equal(buffer, buffer + 4, data));
+            REQUIRE(file.position() == 0);
+        }
+
+        std::remove("positional-file-stream.bin");
+    }
+
+    TEST_CASE("File skip", "[file]")
+    {
+        stdext::file_input_stream file(PATH_STR("UTF-8-test.txt"));
+        auto size = file.end_position();
+
+        file.skip<std::uint32_t>();
+        REQUIRE(file.position() == 4);
+        file.skip_all<char>(12);
+        REQUIRE(file.position() == 16);
+        REQUIRE(file.skip<char>(size_t(size)) == size - 16);
+        REQUIRE(file.position() == size);
+        REQUIRE(file.skip<char>(1) == 0);
+        REQUIRE(file.position() == size);
+
+        file.set_position(size - 2);
+        REQUIRE_THROWS_AS(file.skip<std::uint32_t>(), stdext::stream_error);
+    }
+
+    TEST_CASE("File skip past the end", "[file]")
+    {
+        const stdext::path_char* path = PATH_STR("skip-file-stream.bin");
+        {
+            stdext::file_output_stream out(path);
+            out.write_all("hello world", 11);
+        }
+
+        stdext::file_input_stream file(path);
+        REQUIRE(file.read<char>() == 'h');
+        REQUIRE(file.skip<char>(SIZE_MAX) == 10);
+        REQUIRE(file.position() == 11);
+        char c;
+        REQUIRE(file.read(&c, 1) == 0);
+
+        file.set_position(1);
+        REQUIRE(file.skip<char>(size_t(INTMAX_MAX) + 5) == 10);
+        REQUIRE(file.position() == 11);
+
+        file.set_position(20);
+        REQUIRE(file.skip<char>(SIZE_MAX) == 0);
+        REQUIRE(file.position() == 20);
+
+        file.close();
+        std::remove("skip-file-stream.bin");
+    }
+}
@@ -0,0 +1,260 @@
+#include <stdext/format.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+
+
+namespace test
+{
+    namespace
+    {
+        struct point
+        {
+            int x;
+            int y;
+        };
+
+        template <typename Consumer>
+        bool format_arg(Consumer& out, stdext::string_view spec, const point& p)
+        {
+            auto pattern = spec.compare("x") == 0 ? "(${0:x}, ${1:x})" : "($0, $1)";
+            return stdext::format(out, pattern, p.x, p.y);
+        }
+    }
+
+    TEST_CASE("format", "[format]")
+    {
+        REQUIRE(stdext::format_string("plain") == "plain");
+        REQUIRE(stdext::format_string("$0 and $1", 1, "two") == "1 and two");
+        REQUIRE(stdext::format_string("${1}${0}", 'a', 'b') == "ba");
+        REQUIRE(stdext::format_string("$$$0$$", 5) == "$5$");
+        REQUIRE(stdext::format_string("[${0:04x}|${0:-6d}|${0:+}|${0:#o}|${0:.3}]", 42) == "[002a|42    |+42|052|042]");
+        REQUIRE(stdext::format_string("[${0:3}|${0:-3}]", 'c') == "[  c|c  ]");
+        REQUIRE(stdext::format_string("$0", -17) == "-17");
+
+        REQUIRE(stdext::format_string("[${0:#b}|${0:#X}|${0: d}|${1:.0}|${1:#o}]", 5, 0) == "[0b101|0X5| 5||0]");
+        REQUIRE(stdext::format_string("$0 $1", std::numeric_limits<long long>::min(), std::numeric_limits<unsigned long long>::max())
+            == "-9223372036854775808 18446744073709551615");
+        REQUIRE(stdext::format_string("${0:b}", std::numeric_limits<uint64_t>::max()) == std::string(64, '1'));
+        REQUIRE(stdext::format_string("${0:200}", 1) == std::string(199, ' ') + "1");
+        REQUIRE(stdext::format_string("${0:-40}|", 'c') == "c" + std::string(39, ' ') + "|");
+        REQUIRE(stdext::format_string("${0:3}", L'w') == "  w");
+
+        std::string out;
+        auto consumer = [&](char c) { out += c; return true; };
+        REQUIRE(stdext::format(consumer, "${0:6x}|${1:-5}|", 0xBEEF, 12345678));
+        REQUIRE(out == "  beef|12345678|");
+
+        REQUIRE_THROWS_AS(stdext::format_string("$1", 0), stdext::format_error);
+        REQUIRE_THROWS_AS(stdext::format_string("$x", 0), stdext::format_error);
+    }
+
+    TEST_CASE("format floating point", "[format]")
+    {
+        SECTION("shortest")
+        {
+            REQUIRE(stdext::format_string("$0 $1 $2 $3", 0.1, 1.5, -2.0, 0.0) == "0.1 1.5 -2 0");
+            REQUIRE(stdext::format_string("$0 $1 $2", 1e23, 1e16, 123456789012345.0) == "1e+23 1e+16 123456789012345");
+            REQUIRE(stdext::format_string("$0 $1 $2", 0.001, 0.0001, 1e-5) == "0.001 1e-04 1e-05");
+            REQUIRE(stdext::format_string("$0 $1", 5e-324, std::numeric_limits<double>::max()) == "5e-324 1.7976931348623157e+308");
+            REQUIRE(stdext::format_string("$0 $1", 0.1f, 16777216.0f) == "0.1 16777216");
+            REQUIRE(stdext::format_string("$0 $1", 1e-45f, std::numeric_limits<float>::max()) == "1e-45 3.4028235e+38");
+            REQUIRE(stdext::format_string("${0:e} ${0:E} ${0:f}", 1234.5) == "1.2345e+03 1.2345E+03 1234.5");
+            REQUIRE(stdext::format_string("${0:f} ${1:e}", 1e-7, 0.0) == "0.0000001 0e+00");
+            REQUIRE(stdext::format_string("${0:g} ${0:#} ${1:#e}", 2.0, 3.0) == "2 2. 3.e+00");
+
+            // Fixed notation shows large integers exactly.
+            REQUIRE(stdext::format_string("$0 ${0:f} ${0:.0f}", 1152921504606846976.0) == "1152921504606846976 1152921504606846976 1152921504606846976");
+            REQUIRE(stdext::format_string("${0:f}", 392244953088.0f) == "392244953088");
+            REQUIRE(stdext::format_string("${0:f}", 1e23) == "99999999999999991611392");
+
+            // Round-trips, and in no fewer digits than needed.
+            std::mt19937_64 engine(7);
+            for (int n = 0; n != 10000; ++n)
+            {
+                auto bits = engine();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                if (!std::isfinite(value))
+                    continue;
+
+                auto str = stdext::format_string("${0:e}", value);
+                REQUIRE(std::strtod(str.c_str(), nullptr) == value);
+                auto digits = str.find('e') - (str.find('.') == std::string::npos ? 0 : 1) - (value < 0);
+                if (digits > 1)
+                {
+                    char shorter[32];
+                    std::snprintf(shorter, sizeof(shorter), "%.*e", int(digits) - 2, value);
+                    REQUIRE(std::strtod(shorter, nullptr) != value);
+                }
+            }
+        }
+
+#if defined(__cpp_lib_to_chars)
+        SECTION("shortest matches std::to_chars")
+        {
+            auto check = [](auto value)
+            {
+                char expected[512];
+                auto result = std::to_chars(expected, std::end(expected), value);
+                REQUIRE(stdext::format_string("$0", value) == std::string(expected, result.ptr));
+                result = std::to_chars(expected, std::end(expected), value, std::chars_format::fixed);
+                REQUIRE(stdext::format_string("${0:f}", value) == std::string(expected, result.ptr));
+            };
+
+            std::mt19937_64 engine(13);
+            for (int n = 0; n != 10000; ++n)
+            {
+                auto bits = engine();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                if (n % 2 == 0)
+                    value = double(bits >> (bits % 64));
+                if (std::isfinite(value))
+                    check(value);
+
+                float single;
+                auto single_bits = uint32_t(bits);
+                std::memcpy(&single, &single_bits, sizeof(single));
+                if (n % 2 == 0)
+                    single = float(single_bits >> (bits % 32));
+                if (std::isfinite(single))
+                    check(single);
+            }
+        }
+#endif
+
+        SECTION("precision")
+        {
+            REQUIRE(stdext::format_string("${0:.2f} ${0:.0f} ${1:.0f} ${2:.0f}", 3.14159, 0.5, 1.5) == "3.14 3 0 2");
+            REQUIRE(stdext::format_string("${0:.3e} ${0:.3E} ${0:.3} ${0:.10g}", 12345.678) == "1.235e+04 1.235E+04 1.23e+04 12345.678");
+            REQUIRE(stdext::format_string("${0:.3} ${0:#.3} ${1:.1f}", 0.5, 0.25) == "0.5 0.500 0.2");
+            REQUIRE(stdext::format_string("${0:.30f}", 0.1) == "0.100000000000000005551115123126");
+            REQUIRE(stdext::format_string("${0:.0e}", 5e-324) == "5e-324");
+            REQUIRE(stdext::format_string("${0:.3f}", 1e300).size() == 305);
+
+            static const char* const specs[] = { "%.0f", "%.3f", "%.17f", "%.0e", "%.6e", "%.20e", "%.1g", "%.6g", "%.17g", "%#.3g", "%#.0f" };
+            std::mt19937_64 engine(11);
+            for (int n = 0; n != 2000; ++n)
+            {
+                auto bits = engine();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                if (n % 2 == 0)
+                    value = double(int64_t(bits) >> (bits % 60)) / double(1 << (n % 20));
+                if (!std::isfinite(value))
+                    continue;
+
+                for (auto spec : specs)
+                {
+                    char expected[512];
+                    std::snprintf(expected, sizeof(expected), spec, value);
+                    REQUIRE(stdext::format_string("${0:" + std::string(spec + 1) + "}", value) == expected);
+                }
+            }
+        }
+
+        SECTION("padding and signs")
+        {
+            REQUIRE(stdext::format_string("[${0:8}|${0:-8}|${0:08}|${0:+}|${0: }]", 1.5) == "[     1.5|1.5     |000001.5|+1.5| 1.5]");
+            REQUIRE(stdext::format_string("[${0:+010.2f}|${1:08}]", -2.0, -0.0) == "[-000002.00|-0000000]");
+            REQUIRE(stdext::format_string("${0:.2f}", 1e300).size() == 304);
+            REQUIRE(stdext::format_string("${0:200}", 1.0) == std::string(199, ' ') + "1");
+        }
+
+        SECTION("infinity and NaN")
+        {
+            auto inf = std::numeric_limits<double>::infinity();
+            auto nan = std::numeric_limits<double>::quiet_NaN();
+            REQUIRE(stdext::format_string("$0 $1 ${0:+} ${0:E} ${1:F}", inf, nan) == "inf nan +inf INF NAN");
+            REQUIRE(stdext::format_string("[${0:06}|${0:-5}]", -inf) == "[  -inf|-inf ]");
+            REQUIRE(stdext::format_string("$0", std::numeric_limits<float>::infinity()) == "inf");
+        }
+
+        SECTION("compile-time pattern")
+        {
+            REQUIRE(stdext::format_string(STDEXT_FORMAT("$0 ${1:.2f} ${1:08.3e}"), 0.3, 2.0 / 3) == "0.3 0.67 6.667e-01");
+        }
+
+        REQUIRE_THROWS_AS(stdext::format_string("${0:d}", 1.0), stdext::format_error);
+        REQUIRE_THROWS_AS(stdext::format_string("${0:ee}", 1.0), stdext::format_error);
+    }
+
+    TEST_CASE("formatted_size and format_to", "[format]")
+    {
+        REQUIRE(stdext::formatted_size("") == 0);
+        REQUIRE(stdext::formatted_size("$0=${1:08x} ${2:.2f} $3", "key", 255, 2.5, L"wide") == 22);
+
+        char buffer[32];
+        auto size = stdext::format_to(buffer, "$0=${1:08x} ${2:.2f} $3", "key", 255, 2.5, L"wide");
+        REQUIRE(size == 22);
+        REQUIRE(std::string(buffer, size) == "key=000000ff 2.50 wide");
+
+        // Output beyond the buffer is counted but not written.
+        std::memset(buffer, '#', sizeof(buffer));
+        REQUIRE(stdext::format_to(stdext::span<char>(buffer, 5), "$0 and $1", "one", 2) == 9);
+        REQUIRE(std::string(buffer, 6) == "one a#");
+        REQUIRE(stdext::format_to(stdext::span<char>(), "$0", 12345) == 5);
+
+        auto pattern = STDEXT_FORMAT("[${0:5}|$1]");
+        REQUIRE(stdext::formatted_size(pattern, 42, "x") == 9);
+        size = stdext::format_to(buffer, pattern, 42, "x");
+        REQUIRE(std::string(buffer, size) == "[   42|x]");
+
+        // A long result is sized once and filled in place.
+        std::string long_arg(1000, 'z');
+        REQUIRE(stdext::format_string("<$0>", long_arg) == "<" + long_arg + ">");
+
+        // Invocable arguments still see a stringbuf, and are called only once.
+        int calls = 0;
+        auto invocable = [&](stdext::stringbuf& out) { ++calls; return out("called"); };
+        REQUIRE(stdext::format_string("$0 $1", invocable, 1) == "called 1");
+        REQUIRE(calls == 1);
+    }
+
+    TEST_CASE("format with a compile-time pattern", "[format]")
+    {
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("")) == "");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("plain")) == "plain");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("$0 and $1"), 1, "two") == "1 and two");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("${1}${0}"), 'a', 'b') == "ba");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("$$$0$$"), 5) == "$5$");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("[${0:04x}|${0:-6d}|${0:+}|${0:#o}|${0:.3}]"), 42) == "[002a|42    |+42|052|042]");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("[${0:3}|${0:-3}]"), 'c') == "[  c|c  ]");
+        REQUIRE(stdext::format_string(STDEXT_FORMAT("${10}"), 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, "ten") == "ten");
+
+        auto pattern = STDEXT_FORMAT("key=$0 value=${1:#x}");
+        REQUIRE(pattern.str().compare("key=$0 value=${1:#x}") == 0);
+        REQUIRE(stdext::format_string(pattern, "k", 255u) == stdext::format_string(pattern.str(), "k", 255u));
+
+        SECTION("character consumer")
+        {
+            std::string out;
+            auto consumer = [&](char c) { out += c; return true; };
+            REQUIRE(stdext::format(consumer, STDEXT_FORMAT("a$0b${1:3}"), "x", 7));
+            REQUIRE(out == "axb  7");
+        }
+
+        SECTION("invocable arguments")
+        {
+            auto with_spec = [](stdext::stringbuf& out, stdext::string_view spec) { return out(spec); };
+            REQUIRE(stdext::format_string(STDEXT_FORMAT("<${0:anything}>"), with_spec) == "<anything>");
+        }
+
+        SECTION("arguments with their own format_arg")
+        {
+            point p = { 10, 255 };
+            REQUIRE(stdext::format_string(STDEXT_FORMAT("$0 ${0:x}"), p) == "(10, 255) (a, ff)");
+            REQUIRE(stdext::format_string(STDEXT_FORMAT("${0:x}"), p) == stdext::format_string("${0:x}", p));
+        }
+    }
+}
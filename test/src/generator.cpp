@@ -195,6 +195,19 @@ namespace test
     static_assert(!stdext::can_generate_v<random_access_iterator>);
     static_assert(stdext::can_generate_v<generator>);
 
+    // is_chunked_generator
+    static_assert(!stdext::is_chunked_generator<generator>::value);
+    static_assert(stdext::is_chunked_generator<stdext::delimited_iterator_generator<int*>>::value);
+    static_assert(stdext::is_chunked_generator<stdext::delimited_iterator_generator<const int*>>::value);
+    static_assert(!stdext::is_chunked_generator<stdext::delimited_iterator_generator<input_iterator>>::value);
+    static_assert(stdext::is_chunked_generator<stdext::counted_iterator_generator<const int*>>::value);
+    static_assert(!stdext::is_chunked_generator<stdext::function_generator<int (*)()>>::value);
+
+    // is_chunked_generator_v
+    static_assert(!stdext::is_chunked_generator_v<generator>);
+    static_assert(stdext::is_chunked_generator_v<stdext::delimited_iterator_generator<int*>>);
+    static_assert(!stdext::is_chunked_generator_v<stdext::delimited_iterator_generator<input_iterator>>);
+
     // generator_value_type
     static_assert(std::is_same_v<stdext::generator_value_type<generator>, int>);
     static_assert(std::is_same_v<stdext::generator_value_type<stdext::delimited_iterator_generator<int*>>, int>);
@@ -892,4 +905,39 @@ namespace test
         CHECK(i == j);
         CHECK(f == l);
     }
+
+    TEST_CASE("chunked generators are consumable in bulk", "[generator]")
+    {
+        const int values[] = { 3, 1, 4, 1, 5, 9 };
+        int output[4] = { };
+        stdext::delimited_iterator_consumer out(std::begin(output), std::end(output));
+
+        size_t calls = 0;
+        struct
+        {
+            bool operator () (int value) { return (*out)(value); }
+            size_t operator () (stdext::span<const int> chunk) { ++*calls; return (*out)(chunk); }
+
+            stdext::delimited_iterator_consumer<int*>* out;
+            size_t* calls;
+        } consume = { &out, &calls };
+        static_assert(stdext::is_chunk_consumer_v<decltype(consume), int>);
+
+        auto g = stdext::make_generator(values);
+        REQUIRE_FALSE(g >> consume);
+        CHECK(calls == 1);
+        CHECK(output[0] == 3);
+        CHECK(output[3] == 1);
+
+        // The generator is left at the first element the consumer didn't take.
+        REQUIRE(g);
+        CHECK(*g == 5);
+
+        out = stdext::delimited_iterator_consumer(std::begin(output), std::end(output));
+        REQUIRE(g >> consume);
+        CHECK_FALSE(g);
+        CHECK(calls == 2);
+        CHECK(output[0] == 5);
+        CHECK(output[1] == 9);
+    }
 }
@@ -7,9 +7,14 @@
 //
 
 #include <stdext/stream.h>
+#include <stdext/string.h>
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <memory_resource>
+#include <utility>
+
 
 namespace test
 {
@@ -78,4 +83,342 @@ namespace test
         test(data16);
         test(data32);
     }
+
+    TEST_CASE("Buffered stream operations", "[stream]")
+    {
+        SECTION("buffered_input_stream")
+        {
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::buffered_input_stream is(source, 6);
+
+            REQUIRE(is.peek<std::uint16_t>() == 0x0100);
+            REQUIRE(is.read<std::uint32_t>() == 0x03020100);
+            REQUIRE(is.buffered_size() == 2);
+            REQUIRE(is.peek<std::uint32_t>() == 0x07060504);
+            REQUIRE(is.read<std::uint16_t>() == 0x0504);
+            is.skip<std::uint16_t>();
+            REQUIRE(is.read<std::uint8_t>() == 8);
+
+            size_t count = is.direct_read([](const std::byte* buffer, size_t size)
+            {
+                REQUIRE(size != 0);
+                REQUIRE(buffer[0] == std::byte(9));
+                return size_t(1);
+            });
+            REQUIRE(count == 1);
+
+            std::byte rest[8];
+            REQUIRE(is.read(rest) == 6);
+            REQUIRE(rest[0] == std::byte(0xa));
+            REQUIRE(rest[5] == std::byte(0xf));
+            REQUIRE(is.read(rest) == 0);
+        }
+
+        SECTION("buffered_output_stream")
+        {
+            std::byte buffer[16] = { };
+            stdext::memory_output_stream sink(buffer, sizeof(buffer));
+            stdext::buffered_output_stream os(sink, 4);
+
+            os.write(std::uint16_t(0x0100));
+            REQUIRE(sink.position() == 0);
+            REQUIRE(os.buffered_size() == 2);
+            os.write(std::uint16_t(0x0302));
+            REQUIRE(sink.position() == 0);
+            os.write(std::uint8_t(4));
+            REQUIRE(sink.position() == 4);
+
+            os.write_all(stuff + 5, 6);
+            REQUIRE(sink.position() == 11);
+            REQUIRE(os.buffered_size() == 0);
+
+            size_t count = os.direct_write([](std::byte* buffer, size_t size)
+            {
+                REQUIRE(size == 4);
+                buffer[0] = std::byte(0xb);
+                return size_t(1);
+            });
+            REQUIRE(count == 1);
+
+            os.flush();
+            REQUIRE(sink.position() == 12);
+            REQUIRE(std::equal(buffer, buffer + 12, stuff));
+
+            // A write exactly the size of the buffer goes straight through.
+            os.write_all(stuff + 12, 4);
+            REQUIRE(sink.position() == 16);
+            REQUIRE(os.buffered_size() == 0);
+            REQUIRE(std::equal(buffer, buffer + 16, stuff));
+        }
+    }
+
+    TEST_CASE("Vectored stream operations", "[stream]")
+    {
+        SECTION("read_vectored")
+        {
+            stdext::memory_input_stream is(stuff, sizeof(stuff));
+            std::byte a[3], b[5], c[10];
+            const stdext::span<std::byte> buffers[] = { a, b, c };
+            REQUIRE(is.read_vectored(buffers) == sizeof(stuff));
+            REQUIRE(std::equal(a, a + 3, stuff));
+            REQUIRE(std::equal(b, b + 5, stuff + 3));
+            REQUIRE(std::equal(c, c + 8, stuff + 8));
+
+            is.seek(stdext::seek_from::begin, 0);
+            is.read_all_vectored({ buffers, 2 });
+            REQUIRE(is.position() == 8);
+            REQUIRE_THROWS_AS(is.read_all_vectored(buffers), stdext::stream_error);
+        }
+
+        SECTION("write_vectored")
+        {
+            std::byte buffer[12] = { };
+            stdext::memory_output_stream os(buffer, sizeof(buffer));
+            const stdext::span<const std::byte> buffers[] = { { stuff, 4 }, { stuff + 4, 4 }, { stuff + 8, 8 } };
+            os.write_all_vectored({ buffers, 2 });
+            REQUIRE(os.position() == 8);
+            REQUIRE(os.write_vectored({ buffers + 2, 1 }) == 4);
+            REQUIRE(std::equal(buffer, buffer + 12, stuff));
+        }
+    }
+
+    TEST_CASE("Dynamic memory stream operations", "[stream]")
+    {
+        stdext::dynamic_memory_output_stream<> os;
+        REQUIRE(os.capacity() == 0);
+
+        for (size_t n = 0; n != 100; ++n)
+            os.write_all(stuff, sizeof(stuff));
+        REQUIRE(os.position() == 100 * sizeof(stuff));
+        REQUIRE(os.end_position() == 100 * sizeof(stuff));
+        REQUIRE(os.capacity() >= os.size());
+        for (size_t n = 0; n != 100; ++n)
+            REQUIRE(std::equal(stuff, stuff + sizeof(stuff), os.data() + n * sizeof(stuff)));
+
+        os.set_position(4);
+        os.write(stuff[0]);
+        REQUIRE(os.position() == 5);
+        REQUIRE(os.end_position() == 100 * sizeof(stuff));
+        REQUIRE(os.data()[4] == stuff[0]);
+        REQUIRE_THROWS_AS(os.set_position(os.end_position() + 1), std::invalid_argument);
+
+        os.set_position(os.end_position());
+        auto size = os.direct_write([](std::byte* buffer, size_t size)
+        {
+            REQUIRE(size != 0);
+            buffer[0] = std::byte(0xAB);
+            return size_t(1);
+        });
+        REQUIRE(size == 1);
+        REQUIRE(os.end_position() == 100 * sizeof(stuff) + 1);
+
+        auto data = os.data();
+        auto [buffer, length] = os.extract();
+        REQUIRE(buffer.get() == data);
+        REQUIRE(length == 100 * sizeof(stuff) + 1);
+        REQUIRE(buffer[length - 1] == std::byte(0xAB));
+        REQUIRE(os.size() == 0);
+        REQUIRE(os.capacity() == 0);
+
+        os.write(stuff[1]);
+        REQUIRE(os.size() == 1);
+        REQUIRE(os.data()[0] == stuff[1]);
+
+        auto& self = os;
+        os = std::move(self);
+        REQUIRE(os.size() == 1);
+        REQUIRE(os.data()[0] == stuff[1]);
+
+        stdext::dynamic_memory_output_stream<> other;
+        other = std::move(os);
+        REQUIRE(other.size() == 1);
+        REQUIRE(other.data()[0] == stuff[1]);
+        REQUIRE(os.size() == 0);
+    }
+
+    TEST_CASE("Dynamic memory stream with a polymorphic allocator", "[stream]")
+    {
+        std::pmr::monotonic_buffer_resource resource1, resource2;
+        stdext::dynamic_memory_output_stream<std::pmr::polymorphic_allocator<std::byte>> os(&resource1);
+        os.write_all(stuff, sizeof(stuff));
+        os.set_position(4);
+
+        SECTION("equal allocators")
+        {
+            stdext::dynamic_memory_output_stream<std::pmr::polymorphic_allocator<std::byte>> other(&resource1);
+            auto data = os.data();
+            other = std::move(os);
+            REQUIRE(other.data() == data);
+            REQUIRE(other.get_allocator().resource() == &resource1);
+            REQUIRE(other.size() == sizeof(stuff));
+            REQUIRE(other.position() == 4);
+            REQUIRE(os.size() == 0);
+        }
+
+        SECTION("unequal allocators")
+        {
+            stdext::dynamic_memory_output_stream<std::pmr::polymorphic_allocator<std::byte>> other(&resource2);
+            other.write(stuff[2]);
+            other = std::move(os);
+            REQUIRE(other.data() != os.data());
+            REQUIRE(other.get_allocator().resource() == &resource2);
+            REQUIRE(other.size() == sizeof(stuff));
+            REQUIRE(other.position() == 4);
+            REQUIRE(std::equal(stuff, stuff + sizeof(stuff), other.data()));
+            REQUIRE(os.size() == 0);
+            REQUIRE(os.get_allocator().resource() == &resource1);
+        }
+    }
+
+    TEST_CASE("Segmented memory stream operations", "[stream]")
+    {
+        stdext::memory_segment_pool pool(8);
+        stdext::segmented_memory_stream ss(pool);
+
+        for (size_t n = 0; n != 10; ++n)
+            ss.write_all(stuff, sizeof(stuff));
+        REQUIRE(ss.size() == 10 * sizeof(stuff));
+
+        SECTION("read")
+        {
+            std::byte buffer[sizeof(stuff)];
+            for (size_t n = 0; n != 10; ++n)
+            {
+                ss.read_all(buffer, sizeof(buffer));
+                REQUIRE(std::equal(buffer, buffer + sizeof(buffer), stuff));
+            }
+            REQUIRE(ss.empty());
+            REQUIRE(ss.read(buffer, sizeof(buffer)) == 0);
+        }
+
+        SECTION("direct_read")
+        {
+            size_t offset = 0;
+            size_t segments = 0;
+            while (!ss.empty())
+            {
+                stdext::discard(ss.direct_read([&](const std::byte* buffer, size_t size)
+                {
+                    REQUIRE(size <= pool.segment_size());
+                    for (size_t n = 0; n != size; ++n)
+                        REQUIRE(buffer[n] == stuff[(offset + n) % sizeof(stuff)]);
+                    offset += size;
+                    return size;
+                }));
+                ++segments;
+            }
+            REQUIRE(offset == 10 * sizeof(stuff));
+            REQUIRE(segments == 10 * sizeof(stuff) / pool.segment_size());
+        }
+
+        SECTION("write_to")
+        {
+            ss.skip_all<std::byte>(3);
+            std::byte buffer[10 * sizeof(stuff)];
+            stdext::memory_output_stream os(buffer, sizeof(buffer));
+            REQUIRE(ss.write_to(os) == 10 * sizeof(stuff) - 3);
+            REQUIRE(ss.empty());
+            for (size_t n = 0; n != 10 * sizeof(stuff) - 3; ++n)
+                REQUIRE(buffer[n] == stuff[(n + 3) % sizeof(stuff)]);
+        }
+
+        SECTION("direct_write")
+        {
+            ss.clear();
+            REQUIRE(ss.direct_write([](std::byte* buffer, size_t size)
+            {
+                REQUIRE(size == 8);
+                std::copy_n(stuff, 5, buffer);
+                return size_t(5);
+            }) == 5);
+            ss.write_all(stuff + 5, 5);
+            std::byte buffer[10];
+            ss.read_all(buffer, 10);
+            REQUIRE(std::equal(buffer, buffer + 10, stuff));
+        }
+
+        SECTION("move")
+        {
+            ss.skip_all<std::byte>(3);
+            auto& self = ss;
+            ss = std::move(self);
+            REQUIRE(ss.size() == 10 * sizeof(stuff) - 3);
+
+            stdext::segmented_memory_stream other(pool);
+            other = std::move(ss);
+            REQUIRE(ss.empty());
+            REQUIRE(other.size() == 10 * sizeof(stuff) - 3);
+            std::byte buffer[sizeof(stuff)];
+            other.read_all(buffer, sizeof(buffer));
+            for (size_t n = 0; n != sizeof(buffer); ++n)
+                REQUIRE(buffer[n] == stuff[(n + 3) % sizeof(stuff)]);
+        }
+    }
+
+    TEST_CASE("Stream generators and consumers", "[stream]")
+    {
+        SECTION("direct_readable streams are consumed in chunks")
+        {
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::stream_generator<char> g(source);
+            REQUIRE(g.chunk().size() == sizeof(stuff));
+
+            stdext::stringbuf buf;
+            REQUIRE(g >> buf);
+            CHECK_FALSE(g);
+            auto str = buf.extract();
+            REQUIRE(str.size() == sizeof(stuff));
+            CHECK(std::memcmp(str.data(), stuff, sizeof(stuff)) == 0);
+        }
+
+        SECTION("buffered streams are consumed a buffer at a time")
+        {
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::buffered_input_stream is(source, 6);
+            stdext::stream_generator<char> g(is);
+            REQUIRE(g.chunk().size() == 6);
+
+            stdext::stringbuf buf;
+            REQUIRE(g >> buf);
+            auto str = buf.extract();
+            REQUIRE(str.size() == sizeof(stuff));
+            CHECK(std::memcmp(str.data(), stuff, sizeof(stuff)) == 0);
+        }
+
+        SECTION("the current element stays in the stream")
+        {
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::stream_generator<std::byte> g(source);
+            REQUIRE(*g == std::byte(0));
+            ++g;
+            REQUIRE(*g == std::byte(1));
+            CHECK(source.read<std::byte>() == std::byte(1));
+        }
+
+        SECTION("wider elements are generated one at a time")
+        {
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::stream_generator<uint16_t> g(source);
+            CHECK(g.chunk().empty());
+
+            size_t count = 0;
+            REQUIRE(g >> [&](uint16_t) { ++count; return true; });
+            CHECK(count == std::size(stuff) / 2);
+        }
+
+        SECTION("a consumer takes what fits")
+        {
+            std::byte buffer[10];
+            stdext::memory_output_stream os(buffer, sizeof(buffer));
+            stdext::stream_consumer<std::byte> c(os);
+            static_assert(stdext::is_chunk_consumer_v<decltype(c), std::byte>);
+
+            stdext::memory_input_stream source(stuff, sizeof(stuff));
+            stdext::stream_generator<std::byte> g(source);
+            REQUIRE_FALSE(g >> c);
+            CHECK(std::equal(buffer, buffer + sizeof(buffer), stuff));
+            REQUIRE(g);
+            CHECK(*g == stuff[sizeof(buffer)]);
+        }
+    }
 }
@@ -0,0 +1,58 @@
+#include <stdext/string.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <system_error>
+
+
+namespace test
+{
+    namespace
+    {
+        template <typename Char>
+        std::string to_multibyte(const std::basic_string<Char>& str)
+        {
+            std::string result;
+            for (auto g = str >> stdext::to_multibyte(); g; ++g)
+                result += *g;
+            return result;
+        }
+    }
+
+    TEST_CASE("Narrow and wide conversion", "[string]")
+    {
+        REQUIRE(stdext::to_mbstring(L"") == "");
+        REQUIRE(stdext::to_mbstring(L"plain ASCII") == "plain ASCII");
+        REQUIRE(stdext::to_wstring("plain ASCII") == L"plain ASCII");
+        REQUIRE(to_multibyte(std::wstring(L"plain ASCII")) == "plain ASCII");
+
+        if constexpr (stdext::_private::utf_execution_charsets)
+        {
+            std::wstring wide = L"café € \U0001F600";
+            std::string narrow = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80";
+            REQUIRE(stdext::to_mbstring(wide.c_str()) == narrow);
+            REQUIRE(stdext::to_wstring(narrow.c_str()) == wide);
+            REQUIRE(to_multibyte(wide) == narrow);
+            REQUIRE(to_multibyte(std::u16string(u"café € \U0001F600")) == narrow);
+            REQUIRE(to_multibyte(std::u32string(U"café € \U0001F600")) == narrow);
+
+            // Noncharacters are valid scalar values.
+            REQUIRE(stdext::to_wstring("a\xEF\xBF\xBF" "b") == std::wstring{ L'a', wchar_t(0xFFFF), L'b' });
+            REQUIRE(stdext::to_wstring("\xEF\xB7\x90\xF4\x8F\xBF\xBE") == L"\uFDD0\U0010FFFE");
+            REQUIRE(stdext::to_mbstring(L"x\uFDD0") == "x\xEF\xB7\x90");
+            REQUIRE(stdext::to_mbstring(L"\U0010FFFF") == "\xF4\x8F\xBF\xBF");
+            REQUIRE(to_multibyte(std::wstring(L"x\uFDD0")) == "x\xEF\xB7\x90");
+            REQUIRE(to_multibyte(std::u16string(1, char16_t(0xFFFE))) == "\xEF\xBF\xBE");
+
+            REQUIRE_THROWS_AS(stdext::to_wstring("a\xFF"), std::runtime_error);
+            REQUIRE_THROWS_AS(stdext::to_wstring("a\xE2\x82"), std::runtime_error);
+            REQUIRE_THROWS_AS(stdext::to_wstring("\xED\xA0\x80"), std::runtime_error);
+            REQUIRE_THROWS_AS(stdext::to_wstring("\xE0\x80\xAF"), std::runtime_error);
+            REQUIRE_THROWS_AS(stdext::to_wstring("\xF4\x90\x80\x80"), std::runtime_error);
+            REQUIRE_THROWS_AS(stdext::to_mbstring(std::wstring(1, wchar_t(0xDC00)).c_str()), std::runtime_error);
+            REQUIRE_THROWS_AS(to_multibyte(std::u16string(1, char16_t(0xDC00))), std::system_error);
+            REQUIRE_THROWS_AS(to_multibyte(std::u16string(1, char16_t(0xD800))), std::system_error);
+        }
+    }
+}
@@ -0,0 +1,267 @@
+#include <stdext/string_view.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+
+namespace test
+{
+    TEST_CASE("ASCII case mapping", "[string_view]")
+    {
+        std::string mixed;
+        for (int c = 0; c != 256; ++c)
+            mixed += char(c);
+        mixed += "The Quick Brown Fox Jumps Over The Lazy Dog \xC3\x89";
+
+        std::string lower, upper;
+        for (char c : mixed)
+        {
+            lower += c >= 'A' && c <= 'Z' ? char(c + 0x20) : c;
+            upper += c >= 'a' && c <= 'z' ? char(c - 0x20) : c;
+        }
+
+        // Cover every split between the vectorized loop and the tail.
+        for (size_t size = 0; size <= mixed.size(); size += size < 40 ? 1 : 17)
+        {
+            stdext::string_view str(mixed.data(), size);
+            REQUIRE(stdext::ascii_to_lower(str) == lower.substr(0, size));
+            REQUIRE(stdext::ascii_to_upper(str) == upper.substr(0, size));
+            REQUIRE(stdext::ascii_equal_ignore_case(stdext::string_view(lower.data(), size), stdext::string_view(upper.data(), size)));
+            REQUIRE(stdext::ascii_equal_ignore_case(str, stdext::string_view(upper.data(), size)));
+        }
+
+        auto in_place = mixed;
+        stdext::ascii_to_lower(in_place, in_place.data());
+        REQUIRE(in_place == lower);
+
+        REQUIRE_FALSE(stdext::ascii_equal_ignore_case("abc", "ab"));
+        REQUIRE_FALSE(stdext::ascii_equal_ignore_case("abcdefghijklmnopq", "ABCDEFGHIJKLMNOPR"));
+        REQUIRE_FALSE(stdext::ascii_equal_ignore_case("@bcdefghijklmnopqrstuvwxyz@", "`BCDEFGHIJKLMNOPQRSTUVWXYZ@"));
+        REQUIRE_FALSE(stdext::ascii_equal_ignore_case("abcdefghijklmnopqrstuvwxyz@", "ABCDEFGHIJKLMNOPQRSTUVWXYZ`"));
+        REQUIRE_FALSE(stdext::ascii_equal_ignore_case("\xC3\xA9", "\xC3\x89"));
+    }
+
+    namespace
+    {
+        template <typename T>
+        bool same_bits(T a, T b)
+        {
+            return std::memcmp(&a, &b, sizeof(T)) == 0;
+        }
+
+        void check_double(const char* str)
+        {
+            auto result = stdext::from_chars<double>(str);
+            INFO(str);
+            REQUIRE(result.pos == std::strlen(str));
+            REQUIRE(same_bits(result.value, std::strtod(str, nullptr)));
+        }
+
+        void check_float(const char* str)
+        {
+            auto result = stdext::from_chars<float>(str);
+            INFO(str);
+            REQUIRE(result.pos == std::strlen(str));
+            REQUIRE(same_bits(result.value, std::strtof(str, nullptr)));
+        }
+    }
+
+    TEST_CASE("from_chars for integers", "[string_view]")
+    {
+        // Cover every split between the eight-digit chunks and the tail.
+        uint64_t expected = 0;
+        std::string digits;
+        for (int n = 1; n <= 19; ++n)
+        {
+            digits += char('0' + n % 10);
+            expected = expected * 10 + uint64_t(n % 10);
+            auto str = digits + "x";
+            auto result = stdext::from_chars<uint64_t>(str);
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.value == expected);
+            REQUIRE(result.pos == digits.size());
+        }
+
+        REQUIRE(stdext::from_chars<uint64_t>("18446744073709551615").value == UINT64_MAX);
+        REQUIRE(stdext::from_chars<uint64_t>("000000000000000000000018446744073709551615").value == UINT64_MAX);
+        REQUIRE(stdext::from_chars<uint64_t>("18446744073709551616").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<uint64_t>("20000000000000000000").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<uint64_t>("100000000000000000000").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<uint64_t>("100000000000000000000").pos == 21);
+
+        REQUIRE(stdext::from_chars<int8_t>("127").value == 127);
+        REQUIRE(stdext::from_chars<int8_t>("-128").value == -128);
+        REQUIRE(stdext::from_chars<int8_t>("128").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<int8_t>("-129").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<int64_t>("-9223372036854775808").value == INT64_MIN);
+        REQUIRE(stdext::from_chars<int64_t>("9223372036854775808").ec == std::errc::result_out_of_range);
+        REQUIRE(stdext::from_chars<unsigned>("-1").ec == std::errc::invalid_argument);
+
+        auto result = stdext::from_chars<int>("+1");
+        REQUIRE(result.ec == std::errc::invalid_argument);
+        REQUIRE(result.pos == 0);
+        REQUIRE(stdext::from_chars<int>("-").ec == std::errc::invalid_argument);
+        REQUIRE(stdext::from_chars<int>("").ec == std::errc::invalid_argument);
+
+        REQUIRE(stdext::from_chars<int>("ff", 16).value == 255);
+        REQUIRE(stdext::from_chars<int>("-Zz", 36).value == -1295);
+        REQUIRE(stdext::from_chars<int>("1012", 2).value == 5);
+        REQUIRE(stdext::from_chars<int>("1012", 2).pos == 3);
+        REQUIRE(stdext::from_chars<uint64_t>("ffffffffffffffff", 16).value == UINT64_MAX);
+        REQUIRE(stdext::from_chars<uint64_t>("10000000000000000", 16).ec == std::errc::result_out_of_range);
+    }
+
+    TEST_CASE("from_chars for floating point", "[string_view]")
+    {
+        SECTION("random doubles")
+        {
+            std::mt19937_64 engine(42);
+            char buffer[64];
+            for (int n = 0; n != 20000; ++n)
+            {
+                uint64_t bits = engine();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                if (!std::isfinite(value))
+                    continue;
+                std::snprintf(buffer, sizeof(buffer), n % 2 == 0 ? "%.17g" : "%.6g", value);
+                check_double(buffer);
+                check_float(buffer);
+            }
+        }
+
+        SECTION("edge cases")
+        {
+            for (auto str : { "0", "-0", "0.0", "1", "1.5", "123.456", ".5", "5.", "1e10", "1E-10", "1e+308",
+                "1.7976931348623157e308", "2.2250738585072014e-308", "2.2250738585072011e-308",
+                "4.9406564584124654e-324", "2.4703282292062328e-324", "2.4703282292062327e-324", "1e-400",
+                "9007199254740993", "9007199254740992.5", "9007199254740993.0000000000000000000000001",
+                "123456789012345678901234567890", "0.000000000000000000000000000001234567890123456789012",
+                "7.038531e-26", "3.4028235e38", "1.17549435e-38", "1.4e-45", "16777217",
+                "0.1", "0.2", "0.3", "1e23", "8.98846567431158e307" })
+            {
+                check_double(str);
+                check_float(str);
+            }
+        }
+
+        SECTION("overflow")
+        {
+            auto result = stdext::from_chars<double>("-1e309");
+            REQUIRE(result.ec == std::errc::result_out_of_range);
+            REQUIRE(result.value == -HUGE_VAL);
+            REQUIRE(stdext::from_chars<float>("1e39").ec == std::errc::result_out_of_range);
+            REQUIRE(stdext::from_chars<double>("1e99999999999").ec == std::errc::result_out_of_range);
+            REQUIRE(stdext::from_chars<double>("1e-99999999999").value == 0);
+
+            auto huge = stdext::from_chars<long double>("-1e5000");
+            REQUIRE(huge.ec == std::errc::result_out_of_range);
+            REQUIRE(huge.value == -HUGE_VALL);
+        }
+
+        SECTION("underflow")
+        {
+            auto result = stdext::from_chars<long double>("1e-5000");
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.value == 0);
+            REQUIRE(!std::signbit(result.value));
+
+            result = stdext::from_chars<long double>("-1e-5000");
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.value == 0);
+            REQUIRE(std::signbit(result.value));
+
+            // Subnormal values, given with more digits than the fast path keeps.
+            auto denorm_min = std::numeric_limits<long double>::denorm_min();
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "%.30Le", denorm_min);
+            result = stdext::from_chars<long double>(buffer);
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.value == denorm_min);
+
+            std::snprintf(buffer, sizeof(buffer), "%.30Le", -1000 * denorm_min);
+            result = stdext::from_chars<long double>(buffer);
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.value == -1000 * denorm_min);
+
+            auto value = stdext::from_chars<double>("4.9406564584124654417656879286822137236505980e-324");
+            REQUIRE(value.ec == std::errc());
+            REQUIRE(value.value == std::numeric_limits<double>::denorm_min());
+
+            // Far more digits than can affect the result.
+            std::string digits = buffer;
+            digits.insert(digits.find('e'), 20000, '0');
+            result = stdext::from_chars<long double>(digits);
+            REQUIRE(result.ec == std::errc());
+            REQUIRE(result.pos == digits.size());
+            REQUIRE(result.value == -1000 * denorm_min);
+
+            digits = "0." + std::string(20000, '0') + "1e20001";
+            REQUIRE(stdext::from_chars<long double>(digits).value == 1);
+        }
+
+        SECTION("syntax")
+        {
+            auto result = stdext::from_chars<double>("1.5e");
+            REQUIRE(result.value == 1.5);
+            REQUIRE(result.pos == 3);
+            REQUIRE(stdext::from_chars<double>("1.5e+x").pos == 3);
+            REQUIRE(stdext::from_chars<double>("2e3x").pos == 3);
+            REQUIRE(stdext::from_chars<double>(".").ec == std::errc::invalid_argument);
+            REQUIRE(stdext::from_chars<double>("+1").ec == std::errc::invalid_argument);
+            REQUIRE(stdext::from_chars<double>("e5").ec == std::errc::invalid_argument);
+
+            REQUIRE(stdext::from_chars<double>("InFiNiTy").value == HUGE_VAL);
+            REQUIRE(stdext::from_chars<double>("-inf").value == -HUGE_VAL);
+            REQUIRE(stdext::from_chars<double>("infinit").pos == 3);
+            REQUIRE(std::isnan(stdext::from_chars<float>("nan").value));
+            REQUIRE(stdext::from_chars<double>("nan(0x1_f)").pos == 10);
+            REQUIRE(stdext::from_chars<double>("nan(").pos == 3);
+
+            REQUIRE(stdext::from_chars<long double>("1.25").value == 1.25L);
+            REQUIRE(stdext::from_chars<long double>("-1e10x").pos == 5);
+        }
+    }
+
+    TEST_CASE("sto functions on string_view", "[string_view]")
+    {
+        size_t idx = 0;
+        REQUIRE(stdext::stoi("  -42abc", &idx) == -42);
+        REQUIRE(idx == 5);
+        REQUIRE(stdext::stoi("+17") == 17);
+        REQUIRE(stdext::stoi("0x1F", &idx, 16) == 31);
+        REQUIRE(idx == 4);
+        REQUIRE(stdext::stoi("0x", &idx, 16) == 0);
+        REQUIRE(idx == 1);
+        REQUIRE(stdext::stoi("017", nullptr, 0) == 15);
+        REQUIRE(stdext::stoi("0b101", nullptr, 0) == 5);
+        REQUIRE(stdext::stoi("0", &idx, 0) == 0);
+        REQUIRE(idx == 1);
+        REQUIRE(stdext::stoll("-9223372036854775808") == INT64_MIN);
+        REQUIRE(stdext::stoull("18446744073709551615") == UINT64_MAX);
+        REQUIRE(stdext::stoul("-1") == ULONG_MAX);
+
+        REQUIRE_THROWS_AS(stdext::stoi(""), std::invalid_argument);
+        REQUIRE_THROWS_AS(stdext::stoi("  -"), std::invalid_argument);
+        REQUIRE_THROWS_AS(stdext::stoi("2147483648"), std::out_of_range);
+        REQUIRE_THROWS_AS(stdext::stoull("18446744073709551616"), std::out_of_range);
+
+        REQUIRE(stdext::stod(" +1.5e3", &idx) == 1500);
+        REQUIRE(idx == 7);
+        REQUIRE(stdext::stof("0.1") == 0.1f);
+        REQUIRE(stdext::stold("-2.5") == -2.5L);
+        REQUIRE_THROWS_AS(stdext::stod("+-1"), std::invalid_argument);
+        REQUIRE_THROWS_AS(stdext::stod("x"), std::invalid_argument);
+        REQUIRE_THROWS_AS(stdext::stod("1e400"), std::out_of_range);
+        REQUIRE(stdext::stold("1e-5000") == 0);
+    }
+}
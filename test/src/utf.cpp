@@ -1,15 +1,109 @@
 #include <stdext/file.h>
 #include <stdext/stream.h>
 #include <stdext/unicode.h>
+#include <stdext/utf_stream.h>
 
+#include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include <algorithm>
+#include <deque>
 #include <memory>
+#include <random>
+#include <string>
 
 
 namespace test
 {
+    namespace
+    {
+        template <typename Char>
+        std::basic_string<Char> read_file(const stdext::path_char* path)
+        {
+            stdext::file_input_stream file(path);
+            std::basic_string<Char> str(size_t(file.end_position() / sizeof(Char)), Char());
+            file.read_all(str.data(), str.size());
+            return str;
+        }
+
+        // The offset of the first sequence rejected by the code unit decoder.
+        size_t reference_validate(const std::string& in)
+        {
+            stdext::utfstate_t state = { };
+            size_t start = 0;
+            for (size_t n = 0; n != in.size(); ++n)
+            {
+                if (state.consumed == 0)
+                    start = n;
+                if (stdext::to_utf32(in[n], state).first == stdext::utf_result::error)
+                    return start;
+            }
+
+            return state.consumed == 0 ? in.size() : start;
+        }
+
+        // Converts in a few code units at a time into an output buffer of a few code units at a
+        // time, to exercise resumption from both partial reads and partial writes.
+        template <typename OutChar, typename InChar>
+        std::basic_string<OutChar> convert_in_chunks(const std::basic_string<InChar>& in, size_t in_chunk, size_t out_chunk)
+        {
+            std::basic_string<OutChar> str;
+            stdext::utfstate_t state = { };
+            size_t pos = 0;
+            while (pos != in.size())
+            {
+                auto in_size = std::min(in_chunk, in.size() - pos);
+                auto old_size = str.size();
+                str.resize(old_size + out_chunk);
+
+                auto in_span = stdext::span<const InChar>(in.data() + pos, in_size);
+                auto out_span = stdext::span<OutChar>(str.data() + old_size, out_chunk);
+                stdext::utf_conversion_result result;
+                if constexpr (std::is_same_v<OutChar, char>)
+                    result = stdext::to_utf8(in_span, out_span, state, stdext::utf_conversion_options::sanitize);
+                else if constexpr (std::is_same_v<OutChar, char16_t>)
+                    result = stdext::to_utf16(in_span, out_span, state, stdext::utf_conversion_options::sanitize);
+                else
+                    result = stdext::to_utf32(in_span, out_span, state, stdext::utf_conversion_options::sanitize);
+
+                REQUIRE(result.result != stdext::utf_result::error);
+                str.resize(old_size + result.written);
+                pos += result.read;
+            }
+            return str;
+        }
+
+        // Random UTF-16 or UTF-32 text, mostly valid, with the occasional unpaired surrogate,
+        // noncharacter, or (for UTF-32) out of range value.
+        template <typename Char>
+        std::basic_string<Char> random_utf(std::mt19937& random, size_t size)
+        {
+            static const char32_t code_points[] = { U'a', U'z', U'~', 0xE9, 0x7FF, 0x800, 0x20AC, 0xFFFD, 0x1F600, 0x10FFFD };
+            static const char32_t invalid[] = { 0xD800, 0xDBFF, 0xDC00, 0xDFFF, 0xFDD0, 0xFDEF, 0xFFFE, 0xFFFF, 0x1FFFE, 0x10FFFF, 0x110000 };
+
+            std::basic_string<Char> str;
+            while (str.size() < size)
+            {
+                auto code = random() % 16 == 0
+                    ? invalid[random() % std::size(invalid)]
+                    : random() % 2 == 0 ? U'a' + random() % 26 : code_points[random() % std::size(code_points)];
+
+                if constexpr (sizeof(Char) == sizeof(char16_t))
+                {
+                    if (code >= 0x110000)
+                        continue;
+                    if (code >= 0x10000)
+                    {
+                        str += char16_t(0xD800 | (code - 0x10000) >> 10);
+                        code = 0xDC00 | (code & 0x03FF);
+                    }
+                }
+                str += Char(code);
+            }
+            return str;
+        }
+    }
+
     TEST_CASE("Unicode conversion UTF-8 to UTF-8", "[unicode]")
     {
         stdext::file_input_stream infile(PATH_STR("UTF-8-test.txt"));
@@ -62,6 +156,23 @@ namespace test
 
             REQUIRE(std::equal(buffer.get(), buffer.get() + buffer_size, stdext::input_stream_iterator<std::byte>(testfile)));
         }
+
+        SECTION("to_utf16 (span)")
+        {
+            auto in = read_file<char>(PATH_STR("UTF-8-test.txt"));
+            auto expected = read_file<char16_t>(PATH_STR("UTF-16-post.txt"));
+
+            std::basic_string<char16_t> out(expected.size(), char16_t());
+            stdext::utfstate_t state = { };
+            auto result = stdext::to_utf16(stdext::span<const char>(in), stdext::span<char16_t>(out), state, stdext::utf_conversion_options::sanitize);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.read == in.size());
+            REQUIRE(result.written == expected.size());
+            REQUIRE(out == expected);
+
+            REQUIRE(convert_in_chunks<char16_t>(in, 7, 5) == expected);
+            REQUIRE(convert_in_chunks<char16_t>(in, 61, 2) == expected);
+        }
     }
 
     TEST_CASE("Unicode conversion UTF-8 to UTF-32", "[unicode]")
@@ -89,6 +200,23 @@ namespace test
 
             REQUIRE(std::equal(buffer.get(), buffer.get() + buffer_size, stdext::input_stream_iterator<std::byte>(testfile)));
         }
+
+        SECTION("to_utf32 (span)")
+        {
+            auto in = read_file<char>(PATH_STR("UTF-8-test.txt"));
+            auto expected = read_file<char32_t>(PATH_STR("UTF-32-post.txt"));
+
+            std::basic_string<char32_t> out(expected.size(), char32_t());
+            stdext::utfstate_t state = { };
+            auto result = stdext::to_utf32(stdext::span<const char>(in), stdext::span<char32_t>(out), state, stdext::utf_conversion_options::sanitize);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.read == in.size());
+            REQUIRE(result.written == expected.size());
+            REQUIRE(out == expected);
+
+            REQUIRE(convert_in_chunks<char32_t>(in, 7, 5) == expected);
+            REQUIRE(convert_in_chunks<char32_t>(in, 61, 2) == expected);
+        }
     }
 
     TEST_CASE("Unicode conversion UTF-16 to UTF-8", "[unicode]")
@@ -116,6 +244,19 @@ namespace test
 
             REQUIRE(std::equal(buffer.get(), buffer.get() + buffer_size, stdext::input_stream_iterator<std::byte>(testfile)));
         }
+
+        SECTION("to_u8string (span)")
+        {
+            auto in = read_file<char16_t>(PATH_STR("UTF-16-post.txt"));
+            auto expected = read_file<char>(PATH_STR("UTF-8-post.txt"));
+
+            auto [result, str] = stdext::to_u8string(in);
+            REQUIRE(result == stdext::utf_result::ok);
+            REQUIRE(str == expected);
+
+            REQUIRE(convert_in_chunks<char>(in, 7, 5) == expected);
+            REQUIRE(convert_in_chunks<char>(in, 61, 4) == expected);
+        }
     }
 
     TEST_CASE("Unicode conversion UTF-16 to UTF-16", "[unicode]")
@@ -197,6 +338,19 @@ namespace test
 
             REQUIRE(std::equal(buffer.get(), buffer.get() + buffer_size, stdext::input_stream_iterator<std::byte>(testfile)));
         }
+
+        SECTION("to_u8string (span)")
+        {
+            auto in = read_file<char32_t>(PATH_STR("UTF-32-post.txt"));
+            auto expected = read_file<char>(PATH_STR("UTF-8-post.txt"));
+
+            auto [result, str] = stdext::to_u8string(in);
+            REQUIRE(result == stdext::utf_result::ok);
+            REQUIRE(str == expected);
+
+            REQUIRE(convert_in_chunks<char>(in, 7, 5) == expected);
+            REQUIRE(convert_in_chunks<char>(in, 61, 4) == expected);
+        }
     }
 
     TEST_CASE("Unicode conversion UTF-32 to UTF-16", "[unicode]")
@@ -252,4 +406,282 @@ namespace test
             REQUIRE(std::equal(buffer.get(), buffer.get() + buffer_size, stdext::input_stream_iterator<std::byte>(testfile)));
         }
     }
+
+    TEST_CASE("Unicode span conversion", "[unicode]")
+    {
+        stdext::utfstate_t state = { };
+        char16_t out[8];
+
+        SECTION("partial read")
+        {
+            auto result = stdext::to_utf16(stdext::span<const char>("ab\xE2\x82", 4), stdext::span<char16_t>(out), state);
+            REQUIRE(result.result == stdext::utf_result::partial_read);
+            REQUIRE(result.read == 4);
+            REQUIRE(result.written == 2);
+
+            result = stdext::to_utf16(stdext::span<const char>("\xAC", 1), stdext::span<char16_t>(out + 2, 6), state);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.read == 1);
+            REQUIRE(result.written == 1);
+            REQUIRE(std::u16string_view(out, 3) == u"ab\u20AC");
+        }
+
+        SECTION("partial write")
+        {
+            auto result = stdext::to_utf16(stdext::span<const char>("a\xF0\x9F\x98\x80", 5), stdext::span<char16_t>(out, 2), state);
+            REQUIRE(result.result == stdext::utf_result::partial_write);
+            REQUIRE(result.read == 1);
+            REQUIRE(result.written == 1);
+        }
+
+        SECTION("error")
+        {
+            auto result = stdext::to_utf16(stdext::span<const char>("a\xFF" "b", 3), stdext::span<char16_t>(out), state);
+            REQUIRE(result.result == stdext::utf_result::error);
+            REQUIRE(result.read == 1);
+            REQUIRE(result.written == 1);
+        }
+
+        SECTION("sanitize")
+        {
+            auto result = stdext::to_utf16(stdext::span<const char>("a\xFF" "b\xE2\x82z", 6), stdext::span<char16_t>(out), state, stdext::utf_conversion_options::sanitize);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.read == 6);
+            REQUIRE(std::u16string_view(out, result.written) == u"a\uFFFDb\uFFFDz");
+        }
+    }
+
+    TEST_CASE("UTF-8 validation", "[unicode]")
+    {
+        SECTION("test files")
+        {
+            auto in = read_file<char>(PATH_STR("UTF-8-test.txt"));
+            REQUIRE(stdext::utf8_validate(in) == reference_validate(in));
+
+            auto post = read_file<char>(PATH_STR("UTF-8-post.txt"));
+            REQUIRE(stdext::utf8_validate(post) == post.size());
+        }
+
+        SECTION("noncharacters")
+        {
+            for (std::string nonchar : { "\xEF\xB7\x90", "\xEF\xB7\xAF", "\xEF\xBF\xBE", "\xEF\xBF\xBF", "\xF0\x9F\xBF\xBE", "\xF4\x8F\xBF\xBF" })
+            {
+                for (size_t offset : { 0, 14, 15, 16, 31, 40 })
+                {
+                    auto in = std::string(offset, 'a') + nonchar + std::string(40, 'b');
+                    REQUIRE(stdext::utf8_validate(in) == offset);
+                }
+            }
+        }
+
+        SECTION("random")
+        {
+            // Mostly valid text assembled from fragments, with the occasional stray byte.
+            static const char* const fragments[] =
+            {
+                "abcdefgh", "0123456789abcdef", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF",
+                "\xEF\xBF\xBD", "\xEF\xB7\x8F", "\xF4\x8F\xBF\xBD", "\xE0\xA0\x80", "\xF0\x90\x80\x80"
+            };
+            static const char strays[] = { '\x80', '\xBF', '\xC0', '\xC1', '\xC2', '\xE0', '\xED', '\xEF', '\xF0', '\xF4', '\xF5', '\xFF' };
+
+            std::mt19937 random(12345);
+            for (int iteration = 0; iteration != 2000; ++iteration)
+            {
+                std::string in;
+                while (in.size() < 100)
+                {
+                    if (random() % 16 == 0)
+                        in += strays[random() % std::size(strays)];
+                    else
+                        in += fragments[random() % std::size(fragments)];
+                }
+
+                if (random() % 2 == 0)
+                    in.resize(random() % in.size());
+
+                REQUIRE(stdext::utf8_validate(in) == reference_validate(in));
+            }
+        }
+    }
+
+    TEMPLATE_TEST_CASE("Unicode bulk conversion to UTF-8", "[unicode]", char16_t, char32_t)
+    {
+        std::mt19937 random(54321);
+        for (int iteration = 0; iteration != 500; ++iteration)
+        {
+            auto in = random_utf<TestType>(random, 1 + random() % 80);
+            std::deque<TestType> unit_by_unit(in.begin(), in.end());
+
+            for (auto options : { stdext::utf_conversion_options::none, stdext::utf_conversion_options::sanitize })
+            {
+                auto expected = stdext::to_u8string(unit_by_unit, options);
+                auto actual = stdext::to_u8string(in, options);
+                REQUIRE(actual.first == expected.first);
+                REQUIRE(actual.second == expected.second);
+            }
+        }
+    }
+
+    TEST_CASE("Unicode length of valid text", "[unicode]")
+    {
+        auto utf8 = read_file<char>(PATH_STR("UTF-8-post.txt"));
+        auto utf16 = read_file<char16_t>(PATH_STR("UTF-16-post.txt"));
+        auto utf32 = read_file<char32_t>(PATH_STR("UTF-32-post.txt"));
+
+        REQUIRE(stdext::utf8_count_code_points(utf8) == utf32.size());
+        REQUIRE(stdext::utf16_length_from_utf8(utf8) == utf16.size());
+        REQUIRE(stdext::utf8_length_from_utf16(utf16) == utf8.size());
+
+        for (size_t size = 0; size != 40; ++size)
+        {
+            auto str = std::string(size, 'a') + "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+            REQUIRE(stdext::utf8_count_code_points(str) == size + 3);
+            REQUIRE(stdext::utf16_length_from_utf8(str) == size + 4);
+
+            auto u16str = std::u16string(size, u'a') + u"\u00E9\u20AC\U0001F600";
+            REQUIRE(stdext::utf8_length_from_utf16(u16str) == str.size());
+        }
+    }
+
+    TEST_CASE("Unicode transcoder", "[unicode]")
+    {
+        auto utf8 = read_file<char>(PATH_STR("UTF-8-test.txt"));
+        auto utf16 = read_file<char16_t>(PATH_STR("UTF-16-post.txt"));
+        auto utf32 = read_file<char32_t>(PATH_STR("UTF-32-post.txt"));
+        auto utf8_post = read_file<char>(PATH_STR("UTF-8-post.txt"));
+
+        SECTION("chunked conversion")
+        {
+            for (size_t chunk_size : { 1, 3, 17, 4096 })
+            {
+                stdext::utf_transcoder<char, char16_t> transcoder(stdext::utf_conversion_options::sanitize);
+                std::u16string out;
+                char16_t buffer[5];
+                for (size_t pos = 0; pos != utf8.size(); )
+                {
+                    auto chunk = stdext::span<const char>(utf8.data() + pos, std::min(chunk_size, utf8.size() - pos));
+                    pos += chunk.size();
+                    while (!chunk.empty())
+                    {
+                        auto result = transcoder.convert(chunk, buffer);
+                        REQUIRE(result.result != stdext::utf_result::error);
+                        out.append(buffer, result.written);
+                        chunk = chunk.subspan(result.read);
+                    }
+                }
+
+                REQUIRE(transcoder.finish(buffer).result == stdext::utf_result::ok);
+                REQUIRE(out == utf16);
+            }
+        }
+
+        SECTION("UTF-16 to UTF-32")
+        {
+            stdext::utf_transcoder<char16_t, char32_t> transcoder;
+            std::u32string out(utf32.size(), char32_t());
+            auto result = transcoder.convert(utf16, out);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.written == utf32.size());
+            REQUIRE(out == utf32);
+        }
+
+        SECTION("finish")
+        {
+            char32_t buffer[4];
+            stdext::utf_transcoder<char, char32_t> strict;
+            REQUIRE(strict.convert(stdext::span<const char>("a\xE2\x82", 3), buffer).result == stdext::utf_result::partial_read);
+            REQUIRE(strict.pending());
+            REQUIRE(strict.finish(buffer).result == stdext::utf_result::error);
+
+            stdext::utf_transcoder<char, char32_t> sanitizing(stdext::utf_conversion_options::sanitize);
+            REQUIRE(sanitizing.convert(stdext::span<const char>("a\xE2\x82", 3), buffer).result == stdext::utf_result::partial_read);
+            auto result = sanitizing.finish(buffer);
+            REQUIRE(result.result == stdext::utf_result::ok);
+            REQUIRE(result.written == 1);
+            REQUIRE(buffer[0] == stdext::UNICODE_REPLACEMENT_CHARACTER);
+            REQUIRE(!sanitizing.pending());
+        }
+
+        SECTION("output stream")
+        {
+            stdext::dynamic_memory_output_stream<> out;
+            {
+                stdext::utf_transcoding_output_stream<char16_t, char> transcoding(out, stdext::utf_conversion_options::none, 16);
+                auto bytes = reinterpret_cast<const std::byte*>(utf16.data());
+                auto size = utf16.size() * sizeof(char16_t);
+                for (size_t pos = 0; pos < size; pos += 7)
+                    transcoding.write_all(bytes + pos, std::min(size_t(7), size - pos));
+                transcoding.finish();
+            }
+
+            REQUIRE(std::string_view(reinterpret_cast<const char*>(out.data()), out.size()) == utf8_post);
+        }
+
+        SECTION("output stream errors")
+        {
+            stdext::dynamic_memory_output_stream<> out;
+            stdext::utf_transcoding_output_stream<char, char16_t> strict(out);
+            REQUIRE_THROWS_AS(strict.write_all("a\xFF", 2), stdext::stream_error);
+
+            stdext::utf_transcoding_output_stream<char16_t, char> sanitizing(out, stdext::utf_conversion_options::sanitize);
+            sanitizing.write(u'a');
+            sanitizing.write_all("b", 1);
+            sanitizing.finish();
+            REQUIRE(std::string_view(reinterpret_cast<const char*>(out.data()), out.size()) == "a\xEF\xBF\xBD");
+        }
+    }
+
+    TEST_CASE("Unicode simple case folding", "[unicode]")
+    {
+        SECTION("code points")
+        {
+            REQUIRE(stdext::case_fold(U'A') == U'a');
+            REQUIRE(stdext::case_fold(U'a') == U'a');
+            REQUIRE(stdext::case_fold(U'@') == U'@');
+            REQUIRE(stdext::case_fold(0xC0) == 0xE0);
+            REQUIRE(stdext::case_fold(0xD7) == 0xD7);           // Multiplication sign
+            REQUIRE(stdext::case_fold(0xDF) == 0xDF);           // Sharp s only has a full folding.
+            REQUIRE(stdext::case_fold(0x1E9E) == 0xDF);
+            REQUIRE(stdext::case_fold(0x100) == 0x101);
+            REQUIRE(stdext::case_fold(0x101) == 0x101);
+            REQUIRE(stdext::case_fold(0x130) == 0x130);         // Turkic dotted I is excluded.
+            REQUIRE(stdext::case_fold(0x3A3) == 0x3C3);
+            REQUIRE(stdext::case_fold(0x3C2) == 0x3C3);
+            REQUIRE(stdext::case_fold(0x1F88) == 0x1F80);
+            REQUIRE(stdext::case_fold(0x212A) == U'k');
+            REQUIRE(stdext::case_fold(0x13F8) == 0x13F0);
+            REQUIRE(stdext::case_fold(0xAB70) == 0x13A0);
+            REQUIRE(stdext::case_fold(0xFF21) == 0xFF41);
+            REQUIRE(stdext::case_fold(0x10400) == 0x10428);
+            REQUIRE(stdext::case_fold(0x1E921) == 0x1E943);
+            REQUIRE(stdext::case_fold(0x1E922) == 0x1E922);
+            REQUIRE(stdext::case_fold(0x10FFFF) == 0x10FFFF);
+
+            for (char32_t code = 0; code != 0x110000; ++code)
+            {
+                auto folded = stdext::case_fold(code);
+                if (folded != code)
+                    REQUIRE(stdext::case_fold(folded) == folded);
+            }
+        }
+
+        SECTION("strings")
+        {
+            std::u32string u32str = U"Stra\u00DFe \u212AELVIN \u0391\u03A3\u03C2 \U00010400";
+            std::u32string expected = U"stra\u00DFe kelvin \u03B1\u03C3\u03C3 \U00010428";
+            REQUIRE(stdext::case_fold(u32str) == expected);
+
+            auto u8str = stdext::to_u8string(u32str).second;
+            REQUIRE(stdext::case_fold(u8str) == stdext::to_u8string(expected).second);
+
+            auto u16str = stdext::to_u16string(u32str).second;
+            REQUIRE(stdext::case_fold(u16str) == stdext::to_u16string(expected).second);
+
+            std::string long_ascii(100, 'Q');
+            REQUIRE(stdext::case_fold(long_ascii) == std::string(100, 'q'));
+
+            std::string invalid = "A\xFF" "B\xC3";
+            REQUIRE(stdext::case_fold(invalid) == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+        }
+    }
 }
@@ -0,0 +1,84 @@
+#include <stdext/utf8_indexed_string.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace test
+{
+    namespace
+    {
+        // A mix of one- to four-byte sequences, long enough to span several index entries.
+        std::u32string sample_code_points()
+        {
+            static const char32_t code_points[] = { U'a', 0xE9, 0x20AC, 0x1F600, U'z', 0x7FF, 0x10000 };
+            std::u32string str;
+            for (size_t n = 0; n != 300; ++n)
+                str += code_points[(n * 5 + n / 7) % std::size(code_points)];
+            return str;
+        }
+    }
+
+    TEST_CASE("utf8_indexed_string", "[unicode]")
+    {
+        auto code_points = sample_code_points();
+        stdext::utf8_indexed_string str(stdext::to_u8string(code_points).second);
+        REQUIRE(str.size() == code_points.size());
+
+        SECTION("iteration")
+        {
+            REQUIRE(std::equal(str.begin(), str.end(), code_points.begin(), code_points.end()));
+            REQUIRE(std::equal(str.rbegin(), str.rend(), code_points.rbegin(), code_points.rend()));
+        }
+
+        SECTION("nth code point")
+        {
+            for (size_t n = 0; n != code_points.size(); ++n)
+                REQUIRE(str.nth_code_point(n) == code_points[n]);
+            REQUIRE(str.nth(str.size()) == str.end());
+        }
+
+        SECTION("offsets")
+        {
+            for (size_t n = 0; n != code_points.size(); ++n)
+            {
+                auto offset = str.offset_of(n);
+                auto prefix = code_points.substr(0, n);
+                REQUIRE(offset == stdext::to_u8string(prefix).second.size());
+                for (auto byte = offset; byte != str.offset_of(n + 1); ++byte)
+                    REQUIRE(str.code_point_at(byte) == n);
+            }
+            REQUIRE(str.offset_of(str.size()) == str.size_bytes());
+            REQUIRE(str.code_point_at(str.size_bytes()) == str.size());
+        }
+
+        SECTION("substr")
+        {
+            for (size_t pos : { 0, 1, 63, 64, 65, 200, 299, 300, 400 })
+            {
+                for (size_t count : { 0, 1, 64, 130, 1000 })
+                {
+                    auto expected = pos < code_points.size() ? code_points.substr(pos, count) : std::u32string();
+                    auto sub = str.substr(pos, count);
+                    REQUIRE(std::string(sub.data(), sub.size()) == stdext::to_u8string(expected).second);
+                }
+            }
+        }
+    }
+
+    TEST_CASE("utf8_indexed_string sanitizes its contents", "[unicode]")
+    {
+        stdext::utf8_indexed_string str(std::string("a\xFF" "b\xE2\x82"));
+        REQUIRE(str.str() == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+        REQUIRE(str.size() == 4);
+        REQUIRE(str.nth_code_point(3) == stdext::UNICODE_REPLACEMENT_CHARACTER);
+
+        stdext::utf8_indexed_string empty;
+        REQUIRE(empty.empty());
+        REQUIRE(empty.begin() == empty.end());
+        REQUIRE(empty.substr(0).size() == 0);
+    }
+}